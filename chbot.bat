@@ -0,0 +1 @@
+"build/chbot/debug/chbot"
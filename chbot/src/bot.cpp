@@ -0,0 +1,395 @@
+#include "bot.hpp"
+
+#include <ch/deserializer.hpp>
+#include <ch/peer.hpp>
+#include <ch/world.hpp>
+#include <enet/enet.h>
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+void ch::bot_stats::add(const ch::bot_stats &other)
+{
+    packets_received += other.packets_received;
+    bytes_received += other.bytes_received;
+    packets_sent += other.packets_sent;
+    bytes_sent += other.bytes_sent;
+
+    snapshots += other.snapshots;
+    snapshot_bytes += other.snapshot_bytes;
+    max_snapshot_bytes = std::max(max_snapshot_bytes, other.max_snapshot_bytes);
+
+    input_acks += other.input_acks;
+    total_input_latency += other.total_input_latency;
+    max_input_latency = std::max(max_input_latency, other.max_input_latency);
+
+    total_server_round_trip_time += other.total_server_round_trip_time;
+    max_server_round_trip_time = std::max(max_server_round_trip_time, other.max_server_round_trip_time);
+}
+
+ch::bot::bot(
+    ENetHost *const host,
+    ch::packet_pool &packet_pool,
+    const ENetAddress *const address,
+    const std::shared_ptr<const ch::world> world,
+    const std::uint32_t seed)
+    : world(world),
+      host(host),
+      packet_pool(packet_pool),
+      server_host(address->host),
+      player_key(seed + 1ull),
+      random(seed)
+{
+    peer = std::make_unique<ch::peer>(host, address, ch::channel_count, 0);
+    peer->get_enet_peer()->data = this;
+}
+
+ch::bot::~bot() = default;
+
+bool ch::bot::is_joined() const
+{
+    return joined && !disconnected;
+}
+
+bool ch::bot::is_disconnected() const
+{
+    return disconnected;
+}
+
+std::uint32_t ch::bot::get_round_trip_time() const
+{
+    return peer->get_enet_peer()->roundTripTime;
+}
+
+const ch::bot_stats &ch::bot::get_stats() const
+{
+    return stats;
+}
+
+ch::bot_stats ch::bot::reset_stats()
+{
+    const auto previous_stats = stats;
+    stats = {};
+    return previous_stats;
+}
+
+void ch::bot::handle_connect()
+{
+    if (!pending_resume_token)
+    {
+        return;
+    }
+
+    ch::message_resume message;
+    message.type = ch::message_type::resume;
+    message.resume_token = pending_resume_token;
+    send(message);
+
+    pending_resume_token = 0;
+}
+
+void ch::bot::handle_disconnect()
+{
+    peer->mark_successfully_disconnected();
+
+    // like the real client, a dropped connection gets one attempt at resuming the session with its state intact
+    if (!redirect && resume_token && !leaving)
+    {
+        const auto address = peer->get_enet_peer()->address;
+        peer = std::make_unique<ch::peer>(host, &address, ch::channel_count, ch::peer::resuming);
+        peer->get_enet_peer()->data = this;
+
+        pending_resume_token = resume_token;
+        resume_token = 0;
+        joined = false;
+        return;
+    }
+
+    if (!redirect)
+    {
+        disconnected = true;
+        return;
+    }
+
+    // rejoin at the zone the server handed us off to, starting over like a fresh client
+    ENetAddress address;
+    address.host = server_host;
+    address.port = redirect->port;
+    peer = std::make_unique<ch::peer>(host, &address, ch::channel_count, redirect->token);
+    peer->get_enet_peer()->data = this;
+
+    redirect.reset();
+    resume_token = 0;
+    joined = false;
+    latest_sequence = 0;
+    snapshots = {};
+    in_conversation = false;
+    input_changed = true;
+    sent_inputs.clear();
+}
+
+void ch::bot::handle_packet(const ENetPacket *const packet, const clock::time_point now)
+{
+    stats.packets_received++;
+    stats.bytes_received += packet->dataLength;
+
+    ch::deserializer packet_deserializer(packet->data, packet->dataLength);
+    while (!packet_deserializer.is_at_end())
+    {
+        auto deserializer = packet_deserializer.read_frame();
+        if (!packet_deserializer.is_valid())
+        {
+            spdlog::warn("[Bot] Malformed packet");
+            break;
+        }
+
+        handle_message(deserializer, now);
+    }
+}
+
+void ch::bot::update(const float delta_time, const clock::time_point now)
+{
+    if (!is_joined())
+    {
+        return;
+    }
+
+    action_timer -= delta_time;
+    if (action_timer <= 0)
+    {
+        act();
+
+        action_timer = std::uniform_real_distribution<float>(min_action_delay, max_action_delay)(random);
+    }
+
+    // like the real client, input only goes out when it changes or as a keepalive
+    if (!input_changed && ++updates_since_input < input_keepalive_interval)
+    {
+        return;
+    }
+
+    input_changed = false;
+    updates_since_input = 0;
+
+    sent_inputs.push_back({++input_sequence, now, input_x, input_y});
+    if (sent_inputs.size() > max_sent_inputs)
+    {
+        sent_inputs.pop_front();
+    }
+
+    // acked inputs leave sent_inputs, so its tail is the latest unacked ones
+    ch::message_input message;
+    message.type = ch::message_type::input;
+    message.sequence = input_sequence;
+    const auto count = std::min(sent_inputs.size(), ch::message_input::max_inputs);
+    for (auto input = sent_inputs.end() - static_cast<std::ptrdiff_t>(count); input != sent_inputs.end(); input++)
+    {
+        message.inputs.push_back({input->input_x, input->input_y});
+    }
+    send(message);
+}
+
+void ch::bot::disconnect()
+{
+    redirect.reset();
+    leaving = true;
+
+    if (!disconnected)
+    {
+        peer->disconnect();
+    }
+}
+
+void ch::bot::handle_message(ch::deserializer &deserializer, const clock::time_point now)
+{
+    const auto type = static_cast<ch::message_type>(deserializer.peek_u8());
+
+    switch (type)
+    {
+    case ch::message_type::server_joined:
+    {
+        ch::message_joined message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        joined = true;
+        self_id = message.id;
+        resume_token = message.resume_token;
+        if (message.resumed)
+        {
+            break;
+        }
+
+        // the same bot comes back as the same player, so saved progress gets exercised across runs
+        ch::message_identify identify_message;
+        identify_message.type = ch::message_type::identify;
+        identify_message.player_key = player_key;
+        send(identify_message);
+    }
+    break;
+    case ch::message_type::server_full:
+    {
+        spdlog::warn("[Bot] Server full");
+
+        peer->disconnect();
+    }
+    break;
+    case ch::message_type::redirect:
+    {
+        ch::message_redirect message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        redirect = message;
+        peer->disconnect();
+    }
+    break;
+    case ch::message_type::conversation:
+    {
+        ch::message_conversation message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        in_conversation = message.in_conversation;
+    }
+    break;
+    case ch::message_type::game_state:
+    {
+        ch::message_game_state message;
+        message.read(deserializer);
+        if (!deserializer.is_valid() || message.sequence <= latest_sequence)
+        {
+            break;
+        }
+
+        const ch::snapshot empty_snapshot;
+        const auto &baseline = message.baseline_sequence
+                                   ? snapshots.at(message.baseline_sequence % snapshots.size())
+                                   : empty_snapshot;
+        auto &snapshot = snapshots.at(message.sequence % snapshots.size());
+        if (!snapshot.read(baseline, message, *world, deserializer))
+        {
+            deserializer.invalidate();
+            break;
+        }
+
+        latest_sequence = snapshot.sequence;
+
+        stats.snapshots++;
+        stats.snapshot_bytes += deserializer.get_length();
+        stats.max_snapshot_bytes = std::max<std::uint64_t>(stats.max_snapshot_bytes, deserializer.get_length());
+        stats.total_server_round_trip_time += message.round_trip_time;
+        stats.max_server_round_trip_time = std::max(stats.max_server_round_trip_time, message.round_trip_time);
+
+        {
+            ch::message_sequence ack_message;
+            ack_message.type = ch::message_type::game_state_ack;
+            ack_message.sequence = latest_sequence;
+            send(ack_message);
+        }
+
+        // time from sending an input to seeing the server apply it
+        while (!sent_inputs.empty() && sent_inputs.front().sequence <= message.input_sequence)
+        {
+            if (sent_inputs.front().sequence == message.input_sequence)
+            {
+                const auto latency = std::chrono::duration<double>(now - sent_inputs.front().time).count();
+
+                stats.input_acks++;
+                stats.total_input_latency += latency;
+                stats.max_input_latency = std::max(stats.max_input_latency, latency);
+            }
+
+            sent_inputs.pop_front();
+        }
+    }
+    break;
+    default:
+    {
+        // events about other players don't affect the bot
+    }
+    break;
+    }
+
+    if (!deserializer.is_valid())
+    {
+        spdlog::warn("[Bot] Malformed message of type {}", static_cast<int>(type));
+    }
+}
+
+void ch::bot::act()
+{
+    const auto action = std::uniform_int_distribution<int>(0, 99)(random);
+
+    if (action < 50)
+    {
+        std::uniform_int_distribution<int> axis(-1, 1);
+        input_x = static_cast<std::int8_t>(axis(random));
+        input_y = static_cast<std::int8_t>(axis(random));
+        input_changed = true;
+    }
+    else if (action < 70)
+    {
+        // bots don't interpolate, so they see the latest snapshot
+        ch::message_attack message;
+        message.type = ch::message_type::attack;
+        message.view_tick = latest_sequence ? snapshots.at(latest_sequence % snapshots.size()).tick : 0;
+        send(message);
+    }
+    else if (action < 75)
+    {
+        ch::message_id message;
+        message.type = ch::message_type::change_map;
+        message.id = std::uniform_int_distribution<std::size_t>(0, world->maps.size() - 1)(random);
+        send(message);
+    }
+    else if (!in_conversation)
+    {
+        if (world->conversations.empty())
+        {
+            return;
+        }
+
+        ch::message_id message;
+        message.type = ch::message_type::start_conversation;
+        message.id = std::uniform_int_distribution<std::size_t>(0, world->conversations.size() - 1)(random);
+        send(message);
+    }
+    else if (action < 85)
+    {
+        ch::message message;
+        message.type = ch::message_type::advance_conversation;
+        send(message);
+    }
+    else if (action < 95)
+    {
+        ch::message_id message;
+        message.type = ch::message_type::choose_conversation_response;
+        message.id = std::uniform_int_distribution<std::size_t>(1, 3)(random);
+        send(message);
+    }
+    else
+    {
+        ch::message message;
+        message.type = ch::message_type::end_conversation;
+        send(message);
+    }
+}
+
+void ch::bot::send(const std::vector<std::uint8_t> &buffer, const ch::channel channel)
+{
+    const auto packet = ch::create_message_packet(packet_pool, buffer, channel);
+
+    stats.packets_sent++;
+    stats.bytes_sent += packet->dataLength;
+
+    peer->send(channel, packet);
+}
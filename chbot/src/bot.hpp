@@ -0,0 +1,144 @@
+#ifndef CH_BOT_HPP
+#define CH_BOT_HPP
+
+#include <ch/channel.hpp>
+#include <ch/message.hpp>
+#include <ch/server.hpp>
+#include <ch/snapshot.hpp>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+struct _ENetAddress;
+typedef _ENetAddress ENetAddress;
+
+struct _ENetHost;
+typedef _ENetHost ENetHost;
+
+struct _ENetPacket;
+typedef _ENetPacket ENetPacket;
+
+namespace ch
+{
+    class deserializer;
+    class packet_pool;
+    class peer;
+    class world;
+
+    struct bot_stats
+    {
+        std::uint64_t packets_received = 0;
+        std::uint64_t bytes_received = 0;
+        std::uint64_t packets_sent = 0;
+        std::uint64_t bytes_sent = 0;
+
+        std::uint64_t snapshots = 0;
+        std::uint64_t snapshot_bytes = 0;
+        std::uint64_t max_snapshot_bytes = 0;
+
+        std::uint64_t input_acks = 0;
+        double total_input_latency = 0;
+        double max_input_latency = 0;
+
+        // as the server measures it, reported with each snapshot
+        std::uint64_t total_server_round_trip_time = 0;
+        std::uint32_t max_server_round_trip_time = 0;
+
+        void add(const ch::bot_stats &other);
+    };
+
+    class bot
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        bot(
+            ENetHost *host,
+            ch::packet_pool &packet_pool,
+            const ENetAddress *address,
+            std::shared_ptr<const ch::world> world,
+            std::uint32_t seed);
+        ~bot();
+        bot(const bot &other) = delete;
+        bot &operator=(const bot &other) = delete;
+        bot(bot &&other) = delete;
+        bot &operator=(bot &&other) = delete;
+
+        bool is_joined() const;
+        bool is_disconnected() const;
+        std::uint32_t get_round_trip_time() const;
+
+        const ch::bot_stats &get_stats() const;
+        ch::bot_stats reset_stats();
+
+        // sends the resume token once a reconnection is up
+        void handle_connect();
+        void handle_disconnect();
+        void handle_packet(const ENetPacket *packet, clock::time_point now);
+        void update(float delta_time, clock::time_point now);
+
+        void disconnect();
+
+    private:
+        struct sent_input
+        {
+            std::uint32_t sequence;
+            clock::time_point time;
+            std::int8_t input_x;
+            std::int8_t input_y;
+        };
+
+        static constexpr float min_action_delay = 0.5f;
+        static constexpr float max_action_delay = 3.0f;
+        static constexpr std::size_t max_sent_inputs = 256;
+        static constexpr std::uint32_t input_keepalive_interval = ch::server::tick_rate / 4; // in updates
+
+        std::shared_ptr<const ch::world> world;
+        ENetHost *host;
+        ch::packet_pool &packet_pool;
+        std::uint32_t server_host;
+        std::uint64_t player_key;
+        std::unique_ptr<ch::peer> peer;
+        std::mt19937 random;
+        ch::bot_stats stats;
+
+        bool joined = false;
+        bool disconnected = false;
+        bool leaving = false;
+        std::uint64_t resume_token = 0;
+        std::uint64_t pending_resume_token = 0; // presented once the new connection is up
+        std::size_t self_id = 0;
+        std::optional<ch::message_redirect> redirect;
+
+        std::uint32_t latest_sequence = 0;
+        std::array<ch::snapshot, ch::server::snapshot_history_size> snapshots;
+        bool in_conversation = false;
+
+        std::uint32_t input_sequence = 0;
+        std::int8_t input_x = 0;
+        std::int8_t input_y = 0;
+        bool input_changed = true;
+        std::uint32_t updates_since_input = 0;
+        std::deque<sent_input> sent_inputs;
+        float action_timer = 0;
+
+        void handle_message(ch::deserializer &deserializer, clock::time_point now);
+        void act();
+
+        template <typename T>
+        void send(const T &message)
+        {
+            send(ch::serialize(message), ch::get_channel(message.type));
+        }
+
+        void send(const std::vector<std::uint8_t> &buffer, ch::channel channel);
+    };
+}
+
+#endif
@@ -0,0 +1,229 @@
+#include "bot.hpp"
+#include <SDL2/SDL.h>
+#include <ch/enet.hpp>
+#include <ch/host.hpp>
+#include <ch/packet_pool.hpp>
+#include <ch/sdl.hpp>
+#include <ch/server.hpp>
+#include <ch/tick_scheduler.hpp>
+#include <ch/world.hpp>
+#include <algorithm>
+#include <charconv>
+#include <enet/enet.h>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr const char *default_hostname = "127.0.0.1";
+constexpr std::uint16_t default_port = 8492;
+constexpr std::size_t default_bot_count = 100;
+constexpr std::uint64_t report_interval_ticks = ch::server::tick_rate * 10;
+constexpr std::uint32_t disconnect_timeout = 3000;
+
+namespace
+{
+    // the whole text as a number, rejecting anything else
+    template <typename T>
+    bool parse_number(const std::string_view text, T &value)
+    {
+        const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    void report(const std::vector<std::unique_ptr<ch::bot>> &bots, const double elapsed_time)
+    {
+        ch::bot_stats stats;
+        std::size_t joined_bots = 0;
+        std::uint64_t total_round_trip_time = 0;
+        std::uint32_t max_round_trip_time = 0;
+        for (const auto &bot : bots)
+        {
+            stats.add(bot->reset_stats());
+
+            if (bot->is_joined())
+            {
+                joined_bots++;
+                total_round_trip_time += bot->get_round_trip_time();
+                max_round_trip_time = std::max(max_round_trip_time, bot->get_round_trip_time());
+            }
+        }
+
+        const auto average = [](const double total, const std::uint64_t count)
+        {
+            return count ? total / count : 0.0;
+        };
+
+        spdlog::info(
+            "[Bot] {}/{} joined, rtt {:.0f}ms avg {}ms max, server rtt {:.0f}ms avg {}ms max, input latency {:.0f}ms avg {:.0f}ms max",
+            joined_bots,
+            bots.size(),
+            average(static_cast<double>(total_round_trip_time), joined_bots),
+            max_round_trip_time,
+            average(static_cast<double>(stats.total_server_round_trip_time), stats.snapshots),
+            stats.max_server_round_trip_time,
+            average(stats.total_input_latency, stats.input_acks) * 1000,
+            stats.max_input_latency * 1000);
+        spdlog::info(
+            "[Bot] {:.1f} snapshots/s, snapshot {:.0f} bytes avg {} max, received {:.1f} KiB/s in {:.0f} packets/s, sent {:.1f} KiB/s in {:.0f} packets/s",
+            stats.snapshots / elapsed_time,
+            average(static_cast<double>(stats.snapshot_bytes), stats.snapshots),
+            stats.max_snapshot_bytes,
+            stats.bytes_received / elapsed_time / 1024,
+            stats.packets_received / elapsed_time,
+            stats.bytes_sent / elapsed_time / 1024,
+            stats.packets_sent / elapsed_time);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const auto hostname = argc > 1 ? argv[1] : default_hostname;
+
+    auto port = default_port;
+    if (argc > 2 && (!parse_number(argv[2], port) || !port))
+    {
+        spdlog::error("[Bot] Invalid port {}", argv[2]);
+        return 1;
+    }
+
+    auto bot_count = default_bot_count;
+    if (argc > 3 && (!parse_number(argv[3], bot_count) || !bot_count))
+    {
+        spdlog::error("[Bot] Invalid bot count {}", argv[3]);
+        return 1;
+    }
+
+    const ch::sdl sdl(SDL_INIT_EVENTS);
+    const ch::enet enet;
+
+    const auto world = std::make_shared<ch::world>(
+        "data/world.world",
+        "data/quests.json",
+        "data/conversations.json",
+        "data/items.json");
+
+    // shared by every bot, and declared first so it outlives the host
+    ch::packet_pool packet_pool;
+    const ch::host host(nullptr, bot_count, ch::channel_count, 0, 0);
+
+    ENetAddress address;
+    enet_address_set_host(&address, hostname);
+    address.port = port;
+
+    std::vector<std::unique_ptr<ch::bot>> bots;
+    for (std::size_t i = 0; i < bot_count; i++)
+    {
+        bots.push_back(std::make_unique<ch::bot>(host.get_enet_host(), packet_pool, &address, world, static_cast<std::uint32_t>(i)));
+    }
+
+    spdlog::info("[Bot] Connecting {} bots to {}:{}", bot_count, hostname, port);
+
+    ch::tick_scheduler scheduler(
+        ch::server::tick_rate,
+        ch::server::snapshot_rate,
+        ch::server::max_catch_up_ticks);
+
+    bool running = true;
+    while (running)
+    {
+        SDL_Event event;
+        while (sdl.poll_event(event))
+        {
+            switch (event.type)
+            {
+            case SDL_QUIT:
+            {
+                running = false;
+            }
+            break;
+            }
+        }
+
+        const auto now = ch::bot::clock::now();
+
+        ENetEvent enet_event;
+        while (host.service(&enet_event, 0) > 0)
+        {
+            const auto bot = static_cast<ch::bot *>(enet_event.peer->data);
+
+            switch (enet_event.type)
+            {
+            case ENET_EVENT_TYPE_CONNECT:
+            {
+                bot->handle_connect();
+            }
+            break;
+            case ENET_EVENT_TYPE_RECEIVE:
+            {
+                bot->handle_packet(enet_event.packet, now);
+
+                enet_packet_destroy(enet_event.packet);
+            }
+            break;
+            case ENET_EVENT_TYPE_DISCONNECT:
+            {
+                bot->handle_disconnect();
+            }
+            break;
+            default:
+            {
+            }
+            break;
+            }
+        }
+
+        scheduler.update(
+            [&bots, now](const float delta_time)
+            {
+                for (const auto &bot : bots)
+                {
+                    bot->update(delta_time, now);
+                }
+            },
+            []()
+            {
+            });
+
+        if (scheduler.get_stats().ticks >= report_interval_ticks)
+        {
+            const auto stats = scheduler.reset_stats();
+
+            report(bots, static_cast<double>(stats.ticks) / ch::server::tick_rate);
+        }
+
+        scheduler.wait();
+    }
+
+    for (const auto &bot : bots)
+    {
+        bot->disconnect();
+    }
+
+    ENetEvent event;
+    while (host.service(&event, disconnect_timeout) > 0)
+    {
+        if (event.type == ENET_EVENT_TYPE_RECEIVE)
+        {
+            enet_packet_destroy(event.packet);
+        }
+        else if (event.type == ENET_EVENT_TYPE_DISCONNECT)
+        {
+            static_cast<ch::bot *>(event.peer->data)->handle_disconnect();
+
+            if (std::all_of(
+                    bots.begin(),
+                    bots.end(),
+                    [](const auto &bot)
+                    {
+                        return bot->is_disconnected();
+                    }))
+            {
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
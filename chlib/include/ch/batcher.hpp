@@ -0,0 +1,71 @@
+#ifndef CH_BATCHER_HPP
+#define CH_BATCHER_HPP
+
+#include "channel.hpp"
+#include "message.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ch
+{
+    class host;
+    class packet_pool;
+    struct network_stats;
+
+    // collects a tick's outbound messages as length-prefixed frames and sends one packet per peer and channel on flush
+    // without a host, flushing discards the batches, which lets replays measure encoding without ENet
+    class batcher
+    {
+    public:
+        batcher(const ch::host *host, ch::packet_pool &packet_pool, std::size_t peer_count, ch::network_stats &stats);
+        batcher(const batcher &other) = delete;
+        batcher &operator=(const batcher &other) = delete;
+        batcher(batcher &&other) = delete;
+        batcher &operator=(batcher &&other) = delete;
+
+        template <typename T>
+        void send(const std::size_t peer_id, const T &message)
+        {
+            send(peer_id, ch::get_channel(message.type), ch::serialize(message));
+        }
+
+        template <typename T>
+        void broadcast(const T &message)
+        {
+            broadcast(ch::get_channel(message.type), ch::serialize(message));
+        }
+
+        void send(std::size_t peer_id, ch::channel channel, const std::vector<std::uint8_t> &message);
+        void broadcast(ch::channel channel, const std::vector<std::uint8_t> &message);
+        // one packet for several peers, sent after their direct messages
+        void multicast(const std::vector<std::size_t> &peer_ids, ch::channel channel, const std::vector<std::uint8_t> &message);
+
+        void clear(std::size_t peer_id);
+        void flush();
+
+    private:
+        using channel_buffers = std::array<std::vector<std::uint8_t>, ch::channel_count>;
+
+        struct multicast_batch
+        {
+            std::vector<std::size_t> peer_ids;
+            ch::channel channel;
+            std::vector<std::uint8_t> buffer;
+        };
+
+        const ch::host *host;
+        ch::packet_pool &packet_pool;
+        ch::network_stats &stats;
+        std::vector<channel_buffers> peer_buffers;
+        std::vector<std::size_t> pending_peers;
+        channel_buffers broadcast_buffers;
+        std::vector<multicast_batch> multicasts;
+
+        // empties the buffer, returning nothing without a host
+        ENetPacket *create_packet(std::vector<std::uint8_t> &buffer, ch::channel channel);
+    };
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef CH_CHANNEL_HPP
+#define CH_CHANNEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct _ENetPacket;
+typedef _ENetPacket ENetPacket;
+
+namespace ch
+{
+    class packet_pool;
+    enum class message_type : std::uint8_t;
+
+    // each channel is its own ENet ordering stream, so a resent event never holds back real-time traffic
+    enum class channel : std::uint8_t
+    {
+        events, // reliable and ordered
+        state,  // unreliable and sequenced, stale packets are dropped
+        input   // unreliable and sequenced, stale packets are dropped
+    };
+
+    constexpr std::size_t channel_count = 3;
+
+    ch::channel get_channel(ch::message_type type);
+    std::uint32_t get_packet_flags(ch::channel channel);
+
+    // a packet holding a single framed message
+    ENetPacket *create_message_packet(ch::packet_pool &packet_pool, const std::vector<std::uint8_t> &message, ch::channel channel);
+    // after sending, destroys the packet if no peer took a reference, since ENet leaves a refused packet to the sender
+    void release_unsent_packet(ENetPacket *packet);
+}
+
+#endif
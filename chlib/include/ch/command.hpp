@@ -0,0 +1,47 @@
+#ifndef CH_COMMAND_HPP
+#define CH_COMMAND_HPP
+
+#include "player.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace ch
+{
+    enum class command_type
+    {
+        connect,
+        disconnect,
+        resume,
+        identify,
+
+        input,
+        attack,
+        change_map,
+        start_conversation,
+        advance_conversation,
+        choose_conversation_response,
+        end_conversation,
+
+        quest_status,
+
+        game_state_ack
+    };
+
+    struct command
+    {
+        ch::command_type type;
+        std::size_t peer_id;
+
+        std::size_t id = 0;
+        std::int8_t input_x = 0;
+        std::int8_t input_y = 0;
+        ch::quest_status status = {};
+        std::uint64_t token = 0;     // a resume token presented by the client
+        std::uint64_t new_token = 0; // the resume token to issue, drawn by the listen thread so a recorded session replays with it
+        std::uint32_t address = 0;   // the peer's host
+
+        std::uint32_t round_trip_time = 0; // of the peer when the command arrived, in milliseconds
+    };
+}
+
+#endif
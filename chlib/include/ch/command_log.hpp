@@ -0,0 +1,67 @@
+#ifndef CH_COMMAND_LOG_HPP
+#define CH_COMMAND_LOG_HPP
+
+#include "command.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ch
+{
+    // a command the server processed at the start of a tick, or a snapshot it sent after one
+    struct command_log_entry
+    {
+        std::uint64_t tick = 0;
+        bool snapshot = false;
+        ch::command command = {};
+    };
+
+    // entries are encoded on the calling thread, and flushing hands them to a background thread that writes them out
+    class command_log_writer
+    {
+    public:
+        command_log_writer(const std::string &filename);
+        ~command_log_writer();
+        command_log_writer(const command_log_writer &other) = delete;
+        command_log_writer &operator=(const command_log_writer &other) = delete;
+        command_log_writer(command_log_writer &&other) = delete;
+        command_log_writer &operator=(command_log_writer &&other) = delete;
+
+        void write(const ch::command_log_entry &entry);
+        void flush();
+
+    private:
+        std::ofstream file;
+        std::vector<std::uint8_t> buffer;
+        std::uint64_t previous_tick = 0;
+
+        std::mutex mutex;
+        std::condition_variable pending_available;
+        std::vector<std::uint8_t> pending;
+        bool stopping = false;
+
+        std::thread worker;
+
+        void work();
+    };
+
+    class command_log_reader
+    {
+    public:
+        command_log_reader(const std::string &filename);
+
+        bool read(ch::command_log_entry &entry);
+
+    private:
+        std::vector<std::uint8_t> data;
+        std::size_t offset = 0;
+        std::uint64_t previous_tick = 0;
+    };
+}
+
+#endif
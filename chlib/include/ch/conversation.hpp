@@ -2,9 +2,13 @@
 #define CH_CONVERSATION_NODE_HPP
 
 #include "player.hpp"
-#include <memory>
+#include <cstddef>
+#include <limits>
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <span>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace ch
@@ -18,35 +22,50 @@ namespace ch
 
     struct conversation_condition
     {
-        std::unique_ptr<ch::quest_status> quest_status;
+        std::optional<ch::quest_status> quest_status;
     };
 
     struct conversation_effect
     {
-        std::unique_ptr<ch::quest_status> quest_status;
+        std::optional<ch::quest_status> quest_status;
     };
 
-    struct conversation
+    struct conversation_node
     {
-        const std::size_t root_index;
-        const std::size_t node_index;
+        static constexpr std::size_t no_node = std::numeric_limits<std::size_t>::max();
+
+        std::size_t root_index;
+        std::size_t node_index;
 
         ch::conversation_type type;
         std::string id = "";
         ch::conversation_condition condition;
         ch::conversation_effect effect;
         std::string text = "";
-        std::string jump_id = "";
-
-        std::vector<ch::conversation> children;
+        std::size_t jump_index = no_node; // resolved from jump_id at load time
 
-        conversation(const nlohmann::json &conversation_json, std::size_t root_index, std::size_t *node_index);
+        // children are stored next to each other in the tree's node array
+        std::size_t first_child = 0;
+        std::size_t child_count = 0;
+        bool has_response_nodes = false;
 
-        bool has_response_nodes() const;
         bool check_conditions(const ch::player &player) const;
+    };
+
+    // one dialog tree, flattened so that a node is found by its index and children by a range
+    struct conversation
+    {
+        std::size_t root_index;
+        std::vector<ch::conversation_node> nodes;
+        std::unordered_map<std::string, std::size_t> node_indices; // by id
+
+        conversation(const nlohmann::json &conversation_json, std::size_t root_index);
+
+        const ch::conversation_node &get_root() const;
+        std::span<const ch::conversation_node> get_children(const ch::conversation_node &node) const;
 
-        const ch::conversation *find_by_node_index(std::size_t index) const;
-        const ch::conversation *find_by_id(const std::string &id_to_find) const;
+        const ch::conversation_node *find_by_node_index(std::size_t index) const;
+        const ch::conversation_node *find_by_id(const std::string &id_to_find) const;
     };
 }
 
@@ -0,0 +1,59 @@
+#ifndef CH_COORDINATOR_HPP
+#define CH_COORDINATOR_HPP
+
+#include "channel.hpp"
+#include "message.hpp"
+#include "packet_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace ch
+{
+    class deserializer;
+    class host;
+
+    // knows which zone server owns each map and relays player handoffs between them
+    class coordinator
+    {
+    public:
+        static constexpr std::size_t max_zones = 64;
+
+        coordinator(std::uint16_t port);
+        ~coordinator();
+        coordinator(const coordinator &other) = delete;
+        coordinator &operator=(const coordinator &other) = delete;
+        coordinator(coordinator &&other) = delete;
+        coordinator &operator=(coordinator &&other) = delete;
+
+        void update(std::uint32_t timeout);
+
+    private:
+        struct zone
+        {
+            bool registered = false;
+            std::uint16_t port = 0;
+            std::vector<std::size_t> map_indices;
+        };
+
+        ch::packet_pool packet_pool;
+        std::unique_ptr<ch::host> host;
+        std::vector<zone> zones;                                  // by ENet peer id
+        std::unordered_map<std::size_t, std::size_t> map_owners;  // map index to peer id
+        std::unordered_map<std::uint32_t, std::size_t> handoffs; // token to the peer id handing off
+
+        void handle_message(std::size_t peer_id, ch::deserializer &deserializer);
+
+        template <typename T>
+        void send(const std::size_t peer_id, const T &message)
+        {
+            send(peer_id, ch::serialize(message), ch::get_channel(message.type));
+        }
+
+        void send(std::size_t peer_id, const std::vector<std::uint8_t> &message, ch::channel channel);
+    };
+}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef CH_DESERIALIZER_HPP
+#define CH_DESERIALIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ch
+{
+    class deserializer
+    {
+    public:
+        deserializer(const std::uint8_t *data, std::size_t length);
+
+        std::uint8_t peek_u8();
+        std::uint8_t read_u8();
+        bool read_bool();
+        std::uint64_t read_varint();
+        float read_f32();
+        float read_quantized(float min, float max);
+        ch::deserializer read_frame();
+
+        std::size_t get_length() const;
+        std::size_t get_offset() const;
+        bool is_at_end() const;
+        bool is_valid() const;
+        void invalidate();
+
+    private:
+        const std::uint8_t *data;
+        std::size_t length;
+        std::size_t offset = 0;
+        bool valid = true;
+    };
+}
+
+#endif
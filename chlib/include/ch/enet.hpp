@@ -1,8 +1,11 @@
 #ifndef CH_ENET_HPP
 #define CH_ENET_HPP
 
+#include "pool_allocator.hpp"
+
 namespace ch
 {
+    // ENet's own allocations go through ch::pool_allocator
     class enet
     {
     public:
@@ -12,6 +15,8 @@ namespace ch
         enet &operator=(const enet &other) = delete;
         enet(enet &&other) = delete;
         enet &operator=(enet &&other) = delete;
+
+        static ch::allocation_stats get_allocation_stats();
     };
 }
 
@@ -1,8 +1,11 @@
 #ifndef CH_HOST_HPP
 #define CH_HOST_HPP
 
+#include "channel.hpp"
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
+#include <vector>
 
 struct _ENetAddress;
 typedef _ENetAddress ENetAddress;
@@ -10,6 +13,9 @@ typedef _ENetAddress ENetAddress;
 struct _ENetPacket;
 typedef _ENetPacket ENetPacket;
 
+struct _ENetPeer;
+typedef _ENetPeer ENetPeer;
+
 struct _ENetHost;
 typedef _ENetHost ENetHost;
 
@@ -18,6 +24,14 @@ typedef _ENetEvent ENetEvent;
 
 namespace ch
 {
+    struct peer_sample
+    {
+        std::uint32_t round_trip_time;
+        float packet_loss;
+        float packet_throttle;
+        std::size_t outgoing_queue_size;
+    };
+
     class host
     {
     public:
@@ -34,13 +48,25 @@ namespace ch
         host &operator=(host &&other) = delete;
 
         ENetHost *get_enet_host() const;
+        ENetPeer *get_peer(std::size_t peer_id) const;
+        std::size_t get_connected_peer_count() const;
+        ch::peer_sample sample_peer(std::size_t peer_id) const;
 
-        void broadcast(ENetPacket *packet) const;
+        void broadcast(ch::channel channel, ENetPacket *packet) const;
+        // both take ownership of the packet, even if no peer accepts it
+        int send(ENetPeer *peer, ch::channel channel, ENetPacket *packet) const;
+        // one packet for several peers
+        void multicast(const std::vector<std::size_t> &peer_ids, ch::channel channel, ENetPacket *packet) const;
 
         int service(ENetEvent *event, std::uint32_t timeout) const;
+        // sends whatever is queued without waiting for the next service
+        void flush() const;
+        // blocks until something arrives or the timeout passes, without holding the lock, so other threads can keep sending meanwhile
+        void wait(std::uint32_t timeout) const;
 
     private:
         ENetHost *enet_host;
+        mutable std::mutex mutex;
     };
 }
 
@@ -34,6 +34,7 @@ namespace ch
         const ch::map_tileset &get_tileset(std::size_t gid) const;
 
         bool is_solid(std::size_t x, std::size_t y) const;
+        bool is_solid_at(float x, float y) const;
 
         void update(float delta_time);
     };
@@ -1,15 +1,22 @@
 #ifndef CH_MESSAGE_HPP
 #define CH_MESSAGE_HPP
 
-#include "server.hpp"
-#include <array>
+#include "deserializer.hpp"
+#include "player.hpp"
+#include "serializer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace ch
 {
-    enum class message_type
+    enum class message_type : std::uint8_t
     {
         server_joined,
         server_full,
+        world_state,
+        resume,
+        identify,
 
         player_connected,
         player_disconnected,
@@ -23,54 +30,211 @@ namespace ch
         end_conversation,
 
         quest_status,
+        conversation,
 
-        game_state
+        player_hit,
+
+        game_state,
+        game_state_ack,
+
+        redirect,
+
+        zone_register,
+        handoff,
+        handoff_accepted,
+        handoff_rejected
     };
 
+    constexpr std::size_t message_type_count = static_cast<std::size_t>(ch::message_type::handoff_rejected) + 1;
+
+    // every message is written with its type first, so receivers can peek it to pick the struct to read
     struct message
     {
         message_type type;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
     };
 
     struct message_id : message
     {
         std::size_t id;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
+
+    // for server_joined, with the token that resumes this session if the connection drops
+    struct message_joined : message
+    {
+        std::size_t id;
+        std::uint64_t resume_token;
+        bool resumed;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
+
+    struct world_state_player
+    {
+        std::size_t id;
+        std::vector<ch::quest_status> quest_statuses;
     };
 
+    // everything a joining client needs besides snapshots, built once per tick for everyone joining on it
+    struct message_world_state : message
+    {
+        std::vector<ch::world_state_player> players;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
+
+    // names the player across connections, so the server can find their saved progress
+    // the first message on a connection made with ch::peer::resuming, presenting the token from server_joined
+    struct message_resume : message
+    {
+        std::uint64_t resume_token;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
+
+    struct message_identify : message
+    {
+        std::uint64_t player_key;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
+
+    struct input_sample
+    {
+        std::int8_t input_x;
+        std::int8_t input_y;
+    };
+
+    // inputs are unreliable, so each message repeats the sender's latest unacknowledged ones
     struct message_input : message
     {
-        int8_t input_x;
-        int8_t input_y;
+        static constexpr std::size_t max_inputs = 4;
+
+        std::uint32_t sequence;               // of the last input, the ones before it count down from it
+        std::vector<ch::input_sample> inputs; // oldest first
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
+
+    struct message_attack : message
+    {
+        std::uint64_t view_tick; // the tick the attacker was seeing other players at
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
+
+    struct message_hit : message
+    {
+        std::size_t attacker_id;
+        std::size_t target_id;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
     };
 
     struct message_quest_status : message
     {
         std::size_t id;
         ch::quest_status status;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
+
+    // sent only to the player in the conversation, whenever it moves
+    struct message_conversation : message
+    {
+        bool in_conversation;
+        std::size_t root_index;
+        std::size_t node_index;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
+
+    struct message_sequence : message
+    {
+        std::uint32_t sequence;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
     };
 
     struct message_game_state : message
     {
-        struct player
-        {
-            std::size_t id;
+        std::uint64_t tick;
+        std::uint32_t sequence;
+        std::uint32_t baseline_sequence;
+        std::uint32_t input_sequence;
+        std::uint32_t input_ticks;     // how long the server has simulated with that input
+        std::uint32_t round_trip_time; // as the server measures it, in milliseconds
+        std::size_t player_count;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
 
-            std::size_t map_index;
+    // also used for handoff_accepted, naming the zone that took the player
+    struct message_redirect : message
+    {
+        std::uint16_t port;
+        std::uint32_t token;
 
-            float position_x;
-            float position_y;
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
 
-            ch::direction direction;
-            ch::animation animation;
-            std::size_t frame_index;
+    struct message_token : message
+    {
+        std::uint32_t token;
 
-            bool in_conversation;
-            std::size_t conversation_root_index;
-            std::size_t conversation_node_index;
-        };
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
 
-        std::array<player, ch::server::max_players> players;
+    struct message_zone_register : message
+    {
+        std::uint16_t port;
+        std::vector<std::size_t> map_indices;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
     };
+
+    struct message_handoff : message
+    {
+        std::uint32_t token;
+        std::size_t map_index;
+        float position_x;
+        float position_y;
+        bool in_conversation;
+        std::size_t conversation_root_index;
+        std::size_t conversation_node_index;
+        std::vector<ch::quest_status> quest_statuses;
+
+        void write(ch::serializer &serializer) const;
+        void read(ch::deserializer &deserializer);
+    };
+
+    template <typename T>
+    std::vector<std::uint8_t> serialize(const T &message)
+    {
+        std::vector<std::uint8_t> buffer;
+        ch::serializer serializer(buffer);
+        message.write(serializer);
+        return buffer;
+    }
 }
 
 #endif
@@ -0,0 +1,49 @@
+#ifndef CH_NETWORK_STATS_HPP
+#define CH_NETWORK_STATS_HPP
+
+#include "message.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ch
+{
+    struct peer_network_stats
+    {
+        std::size_t samples = 0;
+        std::uint64_t total_round_trip_time = 0;
+        std::uint32_t max_round_trip_time = 0;
+        float max_packet_loss = 0;
+        float min_packet_throttle = 1;
+        std::size_t max_outgoing_queue_size = 0;
+
+        std::uint64_t packets_sent = 0;
+        std::uint64_t bytes_sent = 0;
+
+        std::uint64_t snapshots_sent = 0;
+        std::uint64_t snapshots_skipped = 0;
+
+        inline float average_round_trip_time() const
+        {
+            return samples ? static_cast<float>(total_round_trip_time) / samples : 0;
+        }
+    };
+
+    struct message_network_stats
+    {
+        std::uint64_t messages_sent = 0;
+        std::uint64_t bytes_sent = 0;
+    };
+
+    struct network_stats
+    {
+        std::vector<ch::peer_network_stats> peers; // by ENet peer id
+        std::array<ch::message_network_stats, ch::message_type_count> message_types;
+
+        std::uint64_t packets_sent = 0;
+        std::uint64_t bytes_sent = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef CH_PACKET_POOL_HPP
+#define CH_PACKET_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct _ENetPacket;
+typedef _ENetPacket ENetPacket;
+
+namespace ch
+{
+    // recycles the buffers that outgoing packets are serialized into, so ENet sends them without copying
+    // ENet frees packets from whichever thread services the host, so the pool has to outlive the host
+    class packet_pool
+    {
+    public:
+        static constexpr std::size_t max_free_buffers = 256;
+
+        packet_pool() = default;
+        ~packet_pool();
+        packet_pool(const packet_pool &other) = delete;
+        packet_pool &operator=(const packet_pool &other) = delete;
+        packet_pool(packet_pool &&other) = delete;
+        packet_pool &operator=(packet_pool &&other) = delete;
+
+        // an empty buffer that keeps the capacity of a previous packet
+        std::vector<std::uint8_t> acquire();
+        // hands the buffer to ENet, it comes back to the pool once ENet destroys the packet
+        ENetPacket *create_packet(std::vector<std::uint8_t> &&buffer, std::uint32_t flags);
+
+        std::size_t get_reused_count() const;
+        std::size_t get_allocated_count() const;
+
+    private:
+        struct packet_buffer
+        {
+            ch::packet_pool *pool;
+            std::vector<std::uint8_t> data;
+        };
+
+        mutable std::mutex mutex;
+        std::vector<std::vector<std::uint8_t>> free_buffers;
+        std::vector<std::unique_ptr<packet_buffer>> free_packet_buffers;
+        std::size_t reused_count = 0;
+        std::size_t allocated_count = 0;
+
+        static void free_packet(ENetPacket *packet);
+        void release(std::unique_ptr<packet_buffer> packet_buffer);
+    };
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef CH_PEER_HPP
 #define CH_PEER_HPP
 
+#include "channel.hpp"
 #include <cstddef>
 #include <cstdint>
 
@@ -21,6 +22,11 @@ namespace ch
     class peer
     {
     public:
+        // the disconnect data of a peer that meant to leave, where a timeout carries 0
+        static constexpr std::uint32_t leaving = 1;
+        // the connect data of a peer that follows up with a resume message, where a fresh join carries 0 and a handoff its token
+        static constexpr std::uint32_t resuming = 1;
+
         peer(
             ENetHost *host,
             const ENetAddress *address,
@@ -32,7 +38,9 @@ namespace ch
         peer(peer &&other) = delete;
         peer &operator=(peer &&other) = delete;
 
-        int send(ENetPacket *packet) const;
+        ENetPeer *get_enet_peer() const;
+
+        int send(ch::channel channel, ENetPacket *packet) const;
 
         void disconnect() const;
 
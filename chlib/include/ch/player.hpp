@@ -9,6 +9,7 @@
 namespace ch
 {
     struct conversation;
+    struct conversation_node;
     class world;
 
     enum class direction
@@ -34,6 +35,10 @@ namespace ch
 
     struct player
     {
+        static constexpr float sprite_size = 16.0f;
+        // there is no equipping, everyone wields the first item
+        static constexpr std::size_t weapon_item_index = 0;
+
         std::size_t id;
 
         std::size_t map_index = 0;
@@ -54,11 +59,13 @@ namespace ch
         std::size_t frame_index = 0;
 
         const ch::conversation *conversation_root = nullptr;
-        const ch::conversation *conversation_node = nullptr;
+        const ch::conversation_node *conversation_node = nullptr;
 
         std::vector<ch::quest_status> quest_statuses;
         std::function<void(const ch::quest_status &)> on_quest_status_set;
 
+        static b2Vec2 get_velocity(std::int8_t input_x, std::int8_t input_y);
+
         void update(float delta_time);
 
         void attack();
@@ -0,0 +1,34 @@
+#ifndef CH_POOL_ALLOCATOR_HPP
+#define CH_POOL_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ch
+{
+    struct allocation_stats
+    {
+        std::uint64_t allocations = 0;
+        std::uint64_t frees = 0;
+        std::uint64_t pooled_allocations = 0; // served from a free list instead of malloc
+        std::uint64_t system_allocations = 0;
+    };
+
+    // size-class allocator for ENet's internal allocations
+    // each thread keeps its own free lists and only locks the shared ones to refill or spill a batch of blocks
+    class pool_allocator
+    {
+    public:
+        static constexpr std::size_t min_block_size = 32;
+        static constexpr std::size_t size_class_count = 8; // up to 4096 bytes, larger goes straight to malloc
+        static constexpr std::size_t max_cached_blocks = 64;
+        static constexpr std::size_t transfer_block_count = 32;
+
+        static void *allocate(std::size_t size);
+        static void deallocate(void *memory);
+
+        static ch::allocation_stats get_stats();
+    };
+}
+
+#endif
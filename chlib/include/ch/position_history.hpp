@@ -0,0 +1,35 @@
+#ifndef CH_POSITION_HISTORY_HPP
+#define CH_POSITION_HISTORY_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace ch
+{
+    struct position_sample
+    {
+        std::uint64_t tick = std::numeric_limits<std::uint64_t>::max();
+        std::size_t map_index = 0;
+        float position_x = 0;
+        float position_y = 0;
+    };
+
+    // where a player was over the last few ticks, for rewinding them to what another client saw
+    class position_history
+    {
+    public:
+        static constexpr std::size_t capacity = 32;
+
+        void record(std::uint64_t tick, std::size_t map_index, float position_x, float position_y);
+        const ch::position_sample *find(std::uint64_t tick) const;
+        void clear();
+
+    private:
+        // indexed by tick, so a lookup is a single slot check
+        std::array<ch::position_sample, capacity> samples;
+    };
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef CH_PROGRESS_STORE_HPP
+#define CH_PROGRESS_STORE_HPP
+
+#include "player.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ch
+{
+    // a player's saved progress, answering a load request
+    struct progress_load
+    {
+        std::size_t peer_id;
+        std::uint64_t player_key;
+        std::vector<ch::quest_status> quest_statuses;
+    };
+
+    // player progress kept by a background thread in an append-only journal, which is compacted into a snapshot once it grows
+    // the calling thread only ever queues requests and collects answers, so it never waits on the disk
+    class progress_store
+    {
+    public:
+        static constexpr std::size_t compaction_record_count = 4096;
+
+        progress_store(const std::string &filename);
+        ~progress_store();
+        progress_store(const progress_store &other) = delete;
+        progress_store &operator=(const progress_store &other) = delete;
+        progress_store(progress_store &&other) = delete;
+        progress_store &operator=(progress_store &&other) = delete;
+
+        void save(std::uint64_t player_key, const ch::quest_status &status);
+        // answered through poll, tagged with the peer that asked
+        void load(std::uint64_t player_key, std::size_t peer_id);
+        void poll(const std::function<void(const ch::progress_load &)> &on_load);
+
+    private:
+        struct request
+        {
+            bool load = false;
+            std::uint64_t player_key = 0;
+            std::size_t peer_id = 0;
+            ch::quest_status status = {};
+        };
+
+        std::string journal_filename;
+        std::string snapshot_filename;
+
+        std::mutex mutex;
+        std::condition_variable requests_available;
+        std::vector<request> requests;
+        bool stopping = false;
+
+        std::mutex loads_mutex;
+        std::vector<ch::progress_load> loads;
+
+        // only touched by the worker
+        std::unordered_map<std::uint64_t, std::vector<ch::quest_status>> progress; // by player key
+        std::ofstream journal;
+        std::size_t journal_record_count = 0;
+
+        std::thread worker;
+
+        void work();
+        void read_snapshot();
+        bool read_journal();
+        void open_journal(bool truncate);
+        void compact();
+        void apply(std::uint64_t player_key, const ch::quest_status &status);
+    };
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef CH_SERIALIZER_HPP
+#define CH_SERIALIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ch
+{
+    class serializer
+    {
+    public:
+        serializer(std::vector<std::uint8_t> &buffer);
+
+        void write_u8(std::uint8_t value);
+        void write_bool(bool value);
+        void write_varint(std::uint64_t value);
+        void write_f32(float value);
+        void write_quantized(float value, float min, float max);
+        void write_frame(const std::vector<std::uint8_t> &message);
+
+    private:
+        std::vector<std::uint8_t> &buffer;
+    };
+}
+
+#endif
@@ -1,27 +1,74 @@
 #ifndef CH_SERVER_HPP
 #define CH_SERVER_HPP
 
+#include "command.hpp"
+#include "message.hpp"
+#include "network_stats.hpp"
+#include "packet_pool.hpp"
 #include "player.hpp"
+#include "position_history.hpp"
+#include "slot_map.hpp"
+#include "spsc_queue.hpp"
 #include <SDL2/SDL.h>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <memory>
+#include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace ch
 {
+    class batcher;
+    class command_log_writer;
+    class deserializer;
     class host;
+    struct peer_sample;
+    class progress_store;
+    class thread_pool;
     class world;
+    class zone_link;
+    struct progress_load;
+    struct snapshot;
 
     class server
     {
     public:
-        static constexpr std::size_t max_players = 32;
+        static constexpr std::size_t default_max_players = 32;
+        static constexpr std::uint32_t tick_rate = 60;
+        static constexpr std::uint32_t snapshot_rate = 20;
+        static constexpr std::size_t max_catch_up_ticks = 5;
+        static constexpr std::size_t command_queue_capacity = 1024;
+        static constexpr std::size_t snapshot_history_size = 32;
+        static constexpr float default_view_radius = 400.0f;
+        static constexpr std::uint64_t handoff_timeout_ticks = tick_rate * 10;
+        static constexpr std::uint64_t resume_grace_ticks = tick_rate * 30;
+        static constexpr std::uint64_t max_rewind_ticks = ch::position_history::capacity - 1;
+        // clients render everyone else this far behind the newest snapshot
+        static constexpr std::uint64_t interpolation_delay_ticks = tick_rate * 2 / snapshot_rate;
 
-        std::array<ch::player, max_players> players;
+        // snapshot rate and size adapt per client, within these bounds
+        static constexpr std::uint32_t max_snapshot_interval = 4;
+        static constexpr float default_snapshot_budget = 16.0f * 1024;
+        static constexpr float min_snapshot_budget = 2.0f * 1024;
+        static constexpr float max_snapshot_budget = 64.0f * 1024;
+        static constexpr float max_snapshot_egress = 1024.0f * 1024;
+
+        ch::slot_map<ch::player> players;
 
         server(
             std::uint16_t port,
-            std::shared_ptr<ch::world> world);
+            std::shared_ptr<ch::world> world,
+            std::size_t max_players,
+            float view_radius);
+        // runs without ENet, for replaying command logs
+        server(
+            std::shared_ptr<ch::world> world,
+            std::size_t max_players,
+            float view_radius);
         ~server();
         server(const server &other) = delete;
         server &operator=(const server &other) = delete;
@@ -30,14 +77,143 @@ namespace ch
 
         void handle_event(const SDL_Event &event);
         void update(float delta_time);
+        void send_game_state();
+
+        std::uint64_t get_tick() const;
+        std::chrono::steady_clock::duration get_simulation_time() const;
+
+        // only simulate the given maps, handing players off through the coordinator when they leave them
+        void start_zone(
+            const std::vector<std::size_t> &map_indices,
+            const char *coordinator_hostname,
+            std::uint16_t coordinator_port);
+
+        // keep quest progress across connections, keyed by what players identify themselves with
+        void start_persistence(const std::string &filename);
+        void start_recording(const std::string &filename);
+        void replay_command(const ch::command &command);
+
+        const ch::network_stats &get_network_stats() const;
+        ch::network_stats reset_network_stats();
 
     private:
+        struct connection
+        {
+            std::size_t peer_id = 0;
+            std::uint32_t acked_sequence = 0;
+            std::uint32_t input_sequence = 0;
+            std::uint64_t input_tick = 0;
+            std::uint64_t acked_tick = 0; // of the newest snapshot the client acked
+            std::uint64_t resume_token = 0;
+            std::uint32_t address = 0; // of the peer, the only host that may take over the session while it's live
+            bool suspended = false; // the connection dropped, and the player waits to be resumed
+            std::uint64_t suspend_tick = 0;
+            std::uint32_t handoff_token = 0;
+            std::uint64_t handoff_expiry_tick = 0; // the player stays here if the handoff hasn't completed by then
+            std::uint64_t player_key = 0;
+            std::uint64_t pending_player_key = 0; // while its saved progress loads
+            std::uint32_t snapshot_interval = 1;  // in snapshots
+            std::uint32_t snapshot_countdown = 0;
+            std::uint32_t snapshots_since_backoff = 0;
+            std::uint32_t uncongested_snapshots = 0;
+            float snapshot_budget = default_snapshot_budget; // bytes per second
+            float snapshot_credit = 0;                       // bytes
+            std::array<std::vector<std::size_t>, snapshot_history_size> visible_players;
+            ch::position_history positions;
+        };
+
+        struct pending_handoff
+        {
+            ch::message_handoff message;
+            std::uint64_t expiry_tick;
+        };
+
+        struct recent_event
+        {
+            std::uint64_t tick;
+            std::vector<std::uint8_t> message;
+        };
+
+        static constexpr std::uint32_t max_snapshot_round_trip_time = 250;
+        static constexpr float max_snapshot_packet_loss = 0.05f;
+        static constexpr float min_snapshot_packet_throttle = 0.75f;
+        static constexpr std::size_t max_snapshot_outgoing_queue_size = 64;
+        static constexpr std::uint32_t snapshot_backoff_delay = snapshot_rate / 4;
+        static constexpr std::uint32_t snapshot_increase_delay = snapshot_rate;
+
+        // a resuming client catches up on events from a little before its last acked snapshot, which can be as old as ENet's longest timeout
+        static constexpr std::uint64_t resume_catch_up_margin_ticks = tick_rate;
+
+        // how far a client's claimed view tick may stray from the one its measured round trip implies
+        static constexpr std::uint64_t view_tick_tolerance_ticks = tick_rate / snapshot_rate * 2;
+        static constexpr std::uint64_t peer_timeout_ticks = tick_rate * 30;
+        static constexpr std::uint64_t recent_event_ticks = resume_grace_ticks + peer_timeout_ticks + resume_catch_up_margin_ticks;
+        // past this, the oldest events go early and resuming clients get the world state instead
+        static constexpr std::size_t max_recent_event_bytes = 256 * 1024;
+
+        static constexpr std::uint32_t listen_timeout = 10; // in milliseconds, bounding how late ENet's pings and resends run
+
+        static constexpr float spawn_x = 100.0f;
+        static constexpr float spawn_y = 100.0f;
+
         std::shared_ptr<ch::world> world;
+        float view_radius;
+        std::uint16_t port = 0;
+        ch::packet_pool packet_pool; // before the host, which frees packets back into it
         std::unique_ptr<ch::host> host;
-        bool listening;
+        std::unique_ptr<ch::batcher> batcher;
+        std::unique_ptr<ch::command_log_writer> command_log;
+        std::unique_ptr<ch::progress_store> progress_store;
+        std::atomic<bool> listening;
         std::thread listen_thread;
+        ch::spsc_queue<ch::command, command_queue_capacity> commands;
+        std::vector<ch::slot_handle> peer_players;                   // by ENet peer id
+        std::vector<bool> resuming_peers;                            // by ENet peer id, connected and yet to present a resume token
+        std::vector<connection> connections;                         // by player id
+        std::unordered_map<std::uint64_t, ch::slot_handle> sessions; // by resume token
+        std::deque<recent_event> recent_events;
+        std::uint64_t recent_events_start_tick = 0; // every event since is still in recent_events
+        std::size_t recent_event_bytes = 0;
+        std::vector<std::size_t> joining_peers;     // waiting for this tick's world state
+        ch::network_stats network_stats;
+        std::unique_ptr<ch::zone_link> zone_link;
+        std::vector<bool> owned_maps;
+        std::size_t spawn_map_index = 0;
+        std::unordered_map<std::uint32_t, pending_handoff> pending_handoffs; // by token
+        std::uint64_t tick = 0;
+        std::unique_ptr<ch::thread_pool> simulation_pool;
+        std::vector<std::vector<ch::player *>> map_players;
+        std::chrono::steady_clock::duration simulation_time = {};
+        std::uint32_t snapshot_sequence = 0;
+        std::vector<ch::snapshot> snapshots;
 
         void listen();
+        void push_command(const ch::command &command);
+        void process_command(const ch::command &command);
+        // well-formed messages can still name maps, conversations or quests that don't exist
+        bool is_in_range(const ch::command &command) const;
+        void join_player(std::size_t peer_id, std::uint32_t handoff_token, std::uint64_t resume_token, std::uint32_t address);
+        void resume_session(std::size_t peer_id, ch::slot_handle handle, std::uint64_t resume_token, std::uint32_t address);
+        void remove_player(ch::slot_handle handle);
+        void expire_sessions();
+        void expire_handoffs();
+        void restore_progress(const ch::progress_load &load);
+        void handle_zone_message(ch::deserializer &deserializer);
+        void start_handoff(ch::player &player, std::size_t map_index);
+
+        std::vector<std::size_t> get_visible_players(const ch::snapshot &snapshot, std::size_t viewer_id) const;
+
+        void sample_network_stats();
+        void adapt_snapshot_rate(connection &connection, const ch::peer_sample &sample) const;
+
+        void resolve_attack(const ch::player &attacker, std::uint64_t view_tick, std::uint32_t round_trip_time);
+        void send_conversation(const ch::player &player);
+        void send_world_state();
+        // a reliable broadcast that is also kept for clients resuming later
+        void broadcast_event(const std::vector<std::uint8_t> &message);
+
+        void create_body(ch::player &player, float x, float y) const;
+        void destroy_body(ch::player &player) const;
     };
 }
 
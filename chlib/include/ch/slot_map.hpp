@@ -0,0 +1,145 @@
+#ifndef CH_SLOT_MAP_HPP
+#define CH_SLOT_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace ch
+{
+    struct slot_handle
+    {
+        std::uint32_t index = std::numeric_limits<std::uint32_t>::max();
+        std::uint32_t generation = 0;
+
+        bool operator==(const slot_handle &other) const = default;
+    };
+
+    // values are kept densely packed so iteration only touches live elements
+    // slots map stable handles to dense positions and bump their generation when freed, so stale handles miss
+    template <typename T>
+    class slot_map
+    {
+    public:
+        slot_map(std::size_t capacity)
+            : slots(capacity)
+        {
+            values.reserve(capacity);
+            slot_indices.reserve(capacity);
+            free_indices.reserve(capacity);
+
+            for (std::size_t i = capacity; i > 0; i--)
+            {
+                free_indices.push_back(static_cast<std::uint32_t>(i - 1));
+            }
+        }
+
+        std::size_t size() const
+        {
+            return values.size();
+        }
+
+        std::size_t capacity() const
+        {
+            return slots.size();
+        }
+
+        bool full() const
+        {
+            return free_indices.empty();
+        }
+
+        ch::slot_handle insert(T value)
+        {
+            const auto index = free_indices.back();
+            free_indices.pop_back();
+
+            auto &slot = slots.at(index);
+            slot.dense_index = values.size();
+            values.push_back(std::move(value));
+            slot_indices.push_back(index);
+
+            return {index, slot.generation};
+        }
+
+        void erase(const ch::slot_handle &handle)
+        {
+            if (!get(handle))
+            {
+                return;
+            }
+
+            auto &slot = slots.at(handle.index);
+            const auto dense_index = slot.dense_index;
+
+            if (dense_index != values.size() - 1)
+            {
+                values.at(dense_index) = std::move(values.back());
+                slot_indices.at(dense_index) = slot_indices.back();
+                slots.at(slot_indices.at(dense_index)).dense_index = dense_index;
+            }
+
+            values.pop_back();
+            slot_indices.pop_back();
+
+            slot.generation++;
+            free_indices.push_back(handle.index);
+        }
+
+        T *get(const ch::slot_handle &handle)
+        {
+            return const_cast<T *>(static_cast<const slot_map *>(this)->get(handle));
+        }
+
+        const T *get(const ch::slot_handle &handle) const
+        {
+            if (handle.index >= slots.size())
+            {
+                return nullptr;
+            }
+
+            const auto &slot = slots.at(handle.index);
+            if (slot.generation != handle.generation || slot.dense_index >= values.size() || slot_indices.at(slot.dense_index) != handle.index)
+            {
+                return nullptr;
+            }
+
+            return &values.at(slot.dense_index);
+        }
+
+        auto begin()
+        {
+            return values.begin();
+        }
+
+        auto end()
+        {
+            return values.end();
+        }
+
+        auto begin() const
+        {
+            return values.begin();
+        }
+
+        auto end() const
+        {
+            return values.end();
+        }
+
+    private:
+        struct slot
+        {
+            std::size_t dense_index = 0;
+            std::uint32_t generation = 0;
+        };
+
+        std::vector<T> values;
+        std::vector<std::uint32_t> slot_indices;
+        std::vector<slot> slots;
+        std::vector<std::uint32_t> free_indices;
+    };
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef CH_SNAPSHOT_HPP
+#define CH_SNAPSHOT_HPP
+
+#include "player.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ch
+{
+    class deserializer;
+    class serializer;
+    class world;
+    struct message_game_state;
+
+    namespace snapshot_field
+    {
+        constexpr std::uint8_t removed = 1 << 0;
+        constexpr std::uint8_t map_index = 1 << 1;
+        constexpr std::uint8_t position = 1 << 2;
+        constexpr std::uint8_t state = 1 << 3;
+        constexpr std::uint8_t frame_index = 1 << 4;
+    }
+
+    struct snapshot_player
+    {
+        std::size_t id = 0;
+
+        std::size_t map_index = 0;
+
+        float position_x = 0;
+        float position_y = 0;
+
+        ch::direction direction = ch::direction::down;
+        ch::animation animation = ch::animation::idle;
+        std::size_t frame_index = 0;
+
+        std::uint8_t diff(const ch::snapshot_player &baseline) const;
+    };
+
+    struct snapshot
+    {
+        std::uint32_t sequence = 0;
+        std::uint64_t tick = 0;
+        // only players that exist, sorted by id
+        std::vector<ch::snapshot_player> players;
+
+        const ch::snapshot_player *find(std::size_t id) const;
+        ch::snapshot filter(const std::vector<std::size_t> &visible_ids) const;
+
+        void write(
+            const ch::snapshot &baseline,
+            std::uint32_t input_sequence,
+            std::uint32_t input_ticks,
+            std::uint32_t round_trip_time,
+            const ch::world &world,
+            ch::serializer &serializer) const;
+        bool read(const ch::snapshot &baseline, const ch::message_game_state &message, const ch::world &world, ch::deserializer &deserializer);
+    };
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef CH_SPSC_QUEUE_HPP
+#define CH_SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace ch
+{
+    template <typename T, std::size_t Capacity>
+    class spsc_queue
+    {
+        static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        bool push(const T &value)
+        {
+            const auto write = write_index.load(std::memory_order_relaxed);
+            if (write - read_index.load(std::memory_order_acquire) == Capacity)
+            {
+                return false;
+            }
+
+            buffer[write & (Capacity - 1)] = value;
+            write_index.store(write + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        bool pop(T &value)
+        {
+            const auto read = read_index.load(std::memory_order_relaxed);
+            if (read == write_index.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            value = buffer[read & (Capacity - 1)];
+            read_index.store(read + 1, std::memory_order_release);
+
+            return true;
+        }
+
+    private:
+        std::array<T, Capacity> buffer;
+        alignas(64) std::atomic<std::size_t> write_index = 0;
+        alignas(64) std::atomic<std::size_t> read_index = 0;
+    };
+}
+
+#endif
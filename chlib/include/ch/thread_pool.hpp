@@ -0,0 +1,48 @@
+#ifndef CH_THREAD_POOL_HPP
+#define CH_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ch
+{
+    class thread_pool
+    {
+    public:
+        thread_pool(std::size_t worker_count);
+        ~thread_pool();
+        thread_pool(const thread_pool &other) = delete;
+        thread_pool &operator=(const thread_pool &other) = delete;
+        thread_pool(thread_pool &&other) = delete;
+        thread_pool &operator=(thread_pool &&other) = delete;
+
+        std::size_t get_worker_count() const;
+
+        // runs job(0) to job(job_count - 1) on the workers and the calling thread, returning once all of them finished
+        void run(std::size_t job_count, const std::function<void(std::size_t)> &job);
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable work_available;
+        std::condition_variable work_done;
+        bool stopping = false;
+
+        std::uint64_t generation = 0;
+        const std::function<void(std::size_t)> *job = nullptr;
+        std::size_t job_count = 0;
+        std::atomic<std::size_t> next_job = 0;
+        std::size_t active_workers = 0;
+
+        void work();
+        void run_jobs(const std::function<void(std::size_t)> &job, std::size_t job_count);
+    };
+}
+
+#endif
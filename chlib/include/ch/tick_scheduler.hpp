@@ -0,0 +1,57 @@
+#ifndef CH_TICK_SCHEDULER_HPP
+#define CH_TICK_SCHEDULER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace ch
+{
+    struct tick_stats
+    {
+        std::uint64_t ticks = 0;
+        std::uint64_t snapshots = 0;
+        std::uint64_t dropped_ticks = 0;
+        float total_budget_usage = 0;
+        float max_budget_usage = 0;
+
+        inline float average_budget_usage() const
+        {
+            return ticks ? total_budget_usage / ticks : 0;
+        }
+    };
+
+    class tick_scheduler
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        tick_scheduler(
+            std::uint32_t tick_rate,
+            std::uint32_t snapshot_rate,
+            std::size_t max_catch_up_ticks);
+
+        float get_delta_time() const;
+        std::uint64_t get_tick() const;
+
+        const ch::tick_stats &get_stats() const;
+        ch::tick_stats reset_stats();
+
+        void update(
+            const std::function<void(float)> &on_tick,
+            const std::function<void()> &on_snapshot);
+        void wait() const;
+
+    private:
+        clock::duration tick_duration;
+        std::uint64_t snapshot_interval;
+        std::size_t max_catch_up_ticks;
+
+        std::uint64_t tick = 0;
+        clock::time_point next_tick_time;
+        ch::tick_stats stats;
+    };
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef CH_ZONE_LINK_HPP
+#define CH_ZONE_LINK_HPP
+
+#include "channel.hpp"
+#include "message.hpp"
+#include "packet_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ch
+{
+    class deserializer;
+    class host;
+    class peer;
+
+    // a zone server's connection to the coordinator
+    class zone_link
+    {
+    public:
+        zone_link(
+            const char *coordinator_hostname,
+            std::uint16_t coordinator_port,
+            std::uint16_t port,
+            const std::vector<std::size_t> &map_indices);
+        ~zone_link();
+        zone_link(const zone_link &other) = delete;
+        zone_link &operator=(const zone_link &other) = delete;
+        zone_link(zone_link &&other) = delete;
+        zone_link &operator=(zone_link &&other) = delete;
+
+        template <typename T>
+        void send(const T &message)
+        {
+            send(ch::serialize(message), ch::get_channel(message.type));
+        }
+
+        void send(const std::vector<std::uint8_t> &message, ch::channel channel);
+        void poll(const std::function<void(ch::deserializer &)> &on_message);
+
+    private:
+        ch::packet_pool packet_pool;
+        std::unique_ptr<ch::host> host;
+        std::unique_ptr<ch::peer> peer;
+        bool connected = false;
+    };
+}
+
+#endif
@@ -0,0 +1,180 @@
+#include <ch/batcher.hpp>
+
+#include <ch/host.hpp>
+#include <ch/network_stats.hpp>
+#include <ch/packet_pool.hpp>
+#include <ch/serializer.hpp>
+
+namespace
+{
+    bool is_empty(const std::array<std::vector<std::uint8_t>, ch::channel_count> &buffers)
+    {
+        for (const auto &buffer : buffers)
+        {
+            if (!buffer.empty())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void count_message(ch::network_stats &stats, const std::vector<std::uint8_t> &message, const std::size_t recipients)
+    {
+        const auto type = message.empty() ? ch::message_type_count : static_cast<std::size_t>(message.front());
+        if (type < ch::message_type_count)
+        {
+            auto &message_stats = stats.message_types.at(type);
+            message_stats.messages_sent += recipients;
+            message_stats.bytes_sent += message.size() * recipients;
+        }
+    }
+}
+
+ch::batcher::batcher(const ch::host *const host, ch::packet_pool &packet_pool, const std::size_t peer_count, ch::network_stats &stats)
+    : host(host),
+      packet_pool(packet_pool),
+      stats(stats),
+      peer_buffers(peer_count)
+{
+}
+
+void ch::batcher::send(const std::size_t peer_id, const ch::channel channel, const std::vector<std::uint8_t> &message)
+{
+    auto &buffers = peer_buffers.at(peer_id);
+    if (is_empty(buffers))
+    {
+        pending_peers.push_back(peer_id);
+    }
+
+    ch::serializer serializer(buffers.at(static_cast<std::size_t>(channel)));
+    serializer.write_frame(message);
+
+    count_message(stats, message, 1);
+}
+
+void ch::batcher::broadcast(const ch::channel channel, const std::vector<std::uint8_t> &message)
+{
+    ch::serializer serializer(broadcast_buffers.at(static_cast<std::size_t>(channel)));
+    serializer.write_frame(message);
+
+    count_message(stats, message, host ? host->get_connected_peer_count() : 1);
+}
+
+void ch::batcher::multicast(const std::vector<std::size_t> &peer_ids, const ch::channel channel, const std::vector<std::uint8_t> &message)
+{
+    if (peer_ids.empty())
+    {
+        return;
+    }
+
+    auto buffer = packet_pool.acquire();
+    ch::serializer serializer(buffer);
+    serializer.write_frame(message);
+    multicasts.push_back({.peer_ids = peer_ids, .channel = channel, .buffer = std::move(buffer)});
+
+    count_message(stats, message, peer_ids.size());
+}
+
+void ch::batcher::clear(const std::size_t peer_id)
+{
+    // the peer stays in pending_peers, flush skips it once its buffers are empty
+    for (auto &buffer : peer_buffers.at(peer_id))
+    {
+        buffer.clear();
+    }
+}
+
+void ch::batcher::flush()
+{
+    // direct messages go first, so a joining peer hears about itself before any broadcasts from the same tick
+    for (const auto peer_id : pending_peers)
+    {
+        auto &buffers = peer_buffers.at(peer_id);
+        for (std::size_t i = 0; i < buffers.size(); i++)
+        {
+            auto &buffer = buffers.at(i);
+            if (buffer.empty())
+            {
+                continue;
+            }
+
+            auto &peer_stats = stats.peers.at(peer_id);
+            peer_stats.packets_sent++;
+            peer_stats.bytes_sent += buffer.size();
+            stats.packets_sent++;
+            stats.bytes_sent += buffer.size();
+
+            const auto channel = static_cast<ch::channel>(i);
+            // the listen thread may have dropped the peer since, in which case the host frees the packet
+            if (const auto packet = create_packet(buffer, channel))
+            {
+                host->send(host->get_peer(peer_id), channel, packet);
+            }
+        }
+    }
+    pending_peers.clear();
+
+    for (auto &multicast : multicasts)
+    {
+        for (const auto peer_id : multicast.peer_ids)
+        {
+            auto &peer_stats = stats.peers.at(peer_id);
+            peer_stats.packets_sent++;
+            peer_stats.bytes_sent += multicast.buffer.size();
+            stats.packets_sent++;
+            stats.bytes_sent += multicast.buffer.size();
+        }
+
+        if (!host)
+        {
+            continue;
+        }
+
+        const auto packet = packet_pool.create_packet(std::move(multicast.buffer), ch::get_packet_flags(multicast.channel));
+        host->multicast(multicast.peer_ids, multicast.channel, packet);
+    }
+    multicasts.clear();
+
+    for (std::size_t i = 0; i < broadcast_buffers.size(); i++)
+    {
+        auto &buffer = broadcast_buffers.at(i);
+        if (buffer.empty())
+        {
+            continue;
+        }
+
+        // broadcasts aren't attributed to peers, they cost the same for everyone
+        const auto recipients = host ? host->get_connected_peer_count() : 1;
+        stats.packets_sent += recipients;
+        stats.bytes_sent += buffer.size() * recipients;
+
+        // ENet shares the one packet between every peer
+        const auto channel = static_cast<ch::channel>(i);
+        if (const auto packet = create_packet(buffer, channel))
+        {
+            host->broadcast(channel, packet);
+        }
+    }
+
+    // out now rather than whenever the listen thread next services the host
+    if (host)
+    {
+        host->flush();
+    }
+}
+
+ENetPacket *ch::batcher::create_packet(std::vector<std::uint8_t> &buffer, const ch::channel channel)
+{
+    if (!host)
+    {
+        buffer.clear();
+        return nullptr;
+    }
+
+    // the batch becomes the packet's data, and the next batch starts in a recycled buffer
+    const auto packet = packet_pool.create_packet(std::move(buffer), ch::get_packet_flags(channel));
+    buffer = packet_pool.acquire();
+    return packet;
+}
@@ -0,0 +1,63 @@
+#include <ch/channel.hpp>
+
+#include <ch/message.hpp>
+#include <ch/packet_pool.hpp>
+#include <ch/serializer.hpp>
+#include <enet/enet.h>
+
+ch::channel ch::get_channel(const ch::message_type type)
+{
+    switch (type)
+    {
+    case ch::message_type::game_state:
+    case ch::message_type::game_state_ack:
+    {
+        return ch::channel::state;
+    }
+    break;
+    case ch::message_type::input:
+    {
+        return ch::channel::input;
+    }
+    break;
+    default:
+    {
+        return ch::channel::events;
+    }
+    break;
+    }
+}
+
+std::uint32_t ch::get_packet_flags(const ch::channel channel)
+{
+    switch (channel)
+    {
+    case ch::channel::events:
+    {
+        return ENET_PACKET_FLAG_RELIABLE;
+    }
+    break;
+    default:
+    {
+        return 0;
+    }
+    break;
+    }
+}
+
+ENetPacket *ch::create_message_packet(ch::packet_pool &packet_pool, const std::vector<std::uint8_t> &message, const ch::channel channel)
+{
+    auto buffer = packet_pool.acquire();
+    ch::serializer serializer(buffer);
+    serializer.write_frame(message);
+
+    return packet_pool.create_packet(std::move(buffer), ch::get_packet_flags(channel));
+}
+
+void ch::release_unsent_packet(ENetPacket *const packet)
+{
+    if (packet->referenceCount == 0)
+    {
+        enet_packet_destroy(packet);
+    }
+}
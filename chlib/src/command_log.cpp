@@ -0,0 +1,272 @@
+#include <ch/command_log.hpp>
+
+#include <algorithm>
+#include <ch/deserializer.hpp>
+#include <ch/serializer.hpp>
+#include <iterator>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::uint8_t magic[] = {'C', 'H', 'C', 'L'};
+    constexpr std::uint8_t version = 5;
+    constexpr std::uint8_t snapshot_marker = 0xff;
+}
+
+ch::command_log_writer::command_log_writer(const std::string &filename)
+    : file(filename, std::ios::binary | std::ios::trunc)
+{
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open command log");
+    }
+
+    buffer.insert(buffer.end(), std::begin(magic), std::end(magic));
+    buffer.push_back(version);
+
+    worker = std::thread(&ch::command_log_writer::work, this);
+}
+
+ch::command_log_writer::~command_log_writer()
+{
+    flush();
+
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    pending_available.notify_one();
+
+    // the worker writes out everything flushed before it returns
+    worker.join();
+}
+
+void ch::command_log_writer::write(const ch::command_log_entry &entry)
+{
+    ch::serializer serializer(buffer);
+
+    // ticks only grow, so deltas keep busy ticks to a byte
+    serializer.write_varint(entry.tick - previous_tick);
+    previous_tick = entry.tick;
+
+    if (entry.snapshot)
+    {
+        serializer.write_u8(snapshot_marker);
+        return;
+    }
+
+    const auto &command = entry.command;
+    serializer.write_u8(static_cast<std::uint8_t>(command.type));
+    serializer.write_varint(command.peer_id);
+
+    switch (command.type)
+    {
+    case ch::command_type::connect:
+    {
+        serializer.write_varint(command.id);
+        serializer.write_varint(command.new_token);
+        serializer.write_varint(command.address);
+    }
+    break;
+    case ch::command_type::resume:
+    {
+        serializer.write_varint(command.token);
+        serializer.write_varint(command.new_token);
+        serializer.write_varint(command.address);
+    }
+    break;
+    case ch::command_type::input:
+    {
+        serializer.write_varint(command.id);
+        serializer.write_u8(static_cast<std::uint8_t>((command.input_x + 1) | ((command.input_y + 1) << 2)));
+    }
+    break;
+    case ch::command_type::attack:
+    {
+        serializer.write_varint(command.id);
+        serializer.write_varint(command.round_trip_time);
+    }
+    break;
+    case ch::command_type::disconnect:
+    case ch::command_type::identify:
+    case ch::command_type::change_map:
+    case ch::command_type::start_conversation:
+    case ch::command_type::choose_conversation_response:
+    case ch::command_type::game_state_ack:
+    {
+        serializer.write_varint(command.id);
+    }
+    break;
+    case ch::command_type::quest_status:
+    {
+        serializer.write_varint(command.status.quest_index);
+        serializer.write_varint(command.status.stage_index);
+    }
+    break;
+    default:
+    {
+    }
+    break;
+    }
+}
+
+void ch::command_log_writer::flush()
+{
+    if (buffer.empty())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        pending.insert(pending.end(), buffer.begin(), buffer.end());
+    }
+    pending_available.notify_one();
+
+    buffer.clear();
+}
+
+void ch::command_log_writer::work()
+{
+    std::vector<std::uint8_t> data;
+    while (true)
+    {
+        {
+            std::unique_lock lock(mutex);
+            pending_available.wait(
+                lock,
+                [this]()
+                {
+                    return !pending.empty() || stopping;
+                });
+
+            if (pending.empty())
+            {
+                break;
+            }
+
+            data.swap(pending);
+        }
+
+        // everything flushed since the last wakeup goes out in one write
+        file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        file.flush();
+        data.clear();
+    }
+}
+
+ch::command_log_reader::command_log_reader(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open command log");
+    }
+
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(magic) + 1 ||
+        !std::equal(std::begin(magic), std::end(magic), data.begin()) ||
+        data.at(sizeof(magic)) != version)
+    {
+        throw std::runtime_error("Invalid command log");
+    }
+
+    offset = sizeof(magic) + 1;
+}
+
+bool ch::command_log_reader::read(ch::command_log_entry &entry)
+{
+    if (offset >= data.size())
+    {
+        return false;
+    }
+
+    ch::deserializer deserializer(data.data() + offset, data.size() - offset);
+
+    entry = {};
+    entry.tick = previous_tick + deserializer.read_varint();
+
+    const auto type = deserializer.read_u8();
+    if (type == snapshot_marker)
+    {
+        entry.snapshot = true;
+    }
+    else if (type <= static_cast<std::uint8_t>(ch::command_type::game_state_ack))
+    {
+        auto &command = entry.command;
+        command.type = static_cast<ch::command_type>(type);
+        command.peer_id = deserializer.read_varint();
+
+        switch (command.type)
+        {
+        case ch::command_type::connect:
+        {
+            command.id = deserializer.read_varint();
+            command.new_token = deserializer.read_varint();
+            command.address = static_cast<std::uint32_t>(deserializer.read_varint());
+        }
+        break;
+        case ch::command_type::resume:
+        {
+            command.token = deserializer.read_varint();
+            command.new_token = deserializer.read_varint();
+            command.address = static_cast<std::uint32_t>(deserializer.read_varint());
+        }
+        break;
+        case ch::command_type::input:
+        {
+            command.id = deserializer.read_varint();
+
+            const auto input = deserializer.read_u8();
+            command.input_x = static_cast<std::int8_t>((input & 0x3) - 1);
+            command.input_y = static_cast<std::int8_t>(((input >> 2) & 0x3) - 1);
+        }
+        break;
+        case ch::command_type::attack:
+        {
+            command.id = deserializer.read_varint();
+            command.round_trip_time = static_cast<std::uint32_t>(deserializer.read_varint());
+        }
+        break;
+        case ch::command_type::disconnect:
+        case ch::command_type::identify:
+        case ch::command_type::change_map:
+        case ch::command_type::start_conversation:
+        case ch::command_type::choose_conversation_response:
+        case ch::command_type::game_state_ack:
+        {
+            command.id = deserializer.read_varint();
+        }
+        break;
+        case ch::command_type::quest_status:
+        {
+            command.status.quest_index = deserializer.read_varint();
+            command.status.stage_index = deserializer.read_varint();
+        }
+        break;
+        default:
+        {
+        }
+        break;
+        }
+    }
+    else
+    {
+        deserializer.invalidate();
+    }
+
+    if (!deserializer.is_valid())
+    {
+        spdlog::warn("[Server] Command log is truncated or malformed at offset {}", offset);
+
+        offset = data.size();
+        return false;
+    }
+
+    offset += deserializer.get_offset();
+    previous_tick = entry.tick;
+
+    return true;
+}
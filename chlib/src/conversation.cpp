@@ -1,136 +1,147 @@
 #include <ch/conversation.hpp>
 
 #include <ch/map.hpp>
+#include <stdexcept>
 
-ch::conversation::conversation(const nlohmann::json &conversation_json, const std::size_t root_index, std::size_t *const node_index)
-    : root_index(root_index),
-      node_index(*node_index)
+namespace
 {
-    const std::string type_string = conversation_json.at("type");
-    if (type_string == "root")
+    std::optional<ch::quest_status> read_quest_status(const nlohmann::json &json)
     {
-        type = ch::conversation_type::root;
-    }
-    else if (type_string == "dialog")
-    {
-        type = ch::conversation_type::dialog;
-    }
-    else if (type_string == "response")
-    {
-        type = ch::conversation_type::response;
-    }
+        if (!json.contains("quest_status"))
+        {
+            return std::nullopt;
+        }
 
-    if (conversation_json.contains("id"))
-    {
-        id = conversation_json.at("id");
-    }
+        const auto quest_status_json = json.at("quest_status");
 
-    if (conversation_json.contains("text"))
-    {
-        text = conversation_json.at("text");
+        ch::quest_status quest_status;
+        quest_status.quest_index = quest_status_json.at("quest_index");
+        quest_status.stage_index = quest_status_json.at("stage_index");
+        return quest_status;
     }
+}
+
+ch::conversation::conversation(const nlohmann::json &conversation_json, const std::size_t root_index)
+    : root_index(root_index)
+{
+    // breadth first, so each node's children land next to each other
+    std::vector<const nlohmann::json *> node_jsons = {&conversation_json};
+    std::vector<std::string> jump_ids;
 
-    if (conversation_json.contains("condition"))
+    for (std::size_t node_index = 0; node_index < node_jsons.size(); node_index++)
     {
-        const auto condition_json = conversation_json.at("condition");
+        const auto &node_json = *node_jsons.at(node_index);
+
+        ch::conversation_node node;
+        node.root_index = root_index;
+        node.node_index = node_index;
 
-        if (condition_json.contains("quest_status"))
+        const std::string type_string = node_json.at("type");
+        if (type_string == "root")
+        {
+            node.type = ch::conversation_type::root;
+        }
+        else if (type_string == "dialog")
         {
-            const auto quest_status_json = condition_json.at("quest_status");
+            node.type = ch::conversation_type::dialog;
+        }
+        else if (type_string == "response")
+        {
+            node.type = ch::conversation_type::response;
+        }
 
-            condition.quest_status = std::make_unique<ch::quest_status>();
-            condition.quest_status->quest_index = quest_status_json.at("quest_index");
-            condition.quest_status->stage_index = quest_status_json.at("stage_index");
+        if (node_json.contains("id"))
+        {
+            node.id = node_json.at("id");
+            node_indices[node.id] = node_index;
         }
-    }
 
-    if (conversation_json.contains("effect"))
-    {
-        const auto effect_json = conversation_json.at("effect");
+        if (node_json.contains("text"))
+        {
+            node.text = node_json.at("text");
+        }
 
-        if (effect_json.contains("quest_status"))
+        if (node_json.contains("condition"))
         {
-            const auto quest_status_json = effect_json.at("quest_status");
+            node.condition.quest_status = read_quest_status(node_json.at("condition"));
+        }
 
-            effect.quest_status = std::make_unique<ch::quest_status>();
-            effect.quest_status->quest_index = quest_status_json.at("quest_index");
-            effect.quest_status->stage_index = quest_status_json.at("stage_index");
+        if (node_json.contains("effect"))
+        {
+            node.effect.quest_status = read_quest_status(node_json.at("effect"));
         }
-    }
 
-    if (conversation_json.contains("jump_id"))
-    {
-        jump_id = conversation_json.at("jump_id");
-    }
+        jump_ids.push_back(node_json.contains("jump_id") ? node_json.at("jump_id").get<std::string>() : "");
 
-    if (conversation_json.contains("children"))
-    {
-        for (const auto &child_json : conversation_json.at("children"))
+        if (node_json.contains("children"))
         {
-            (*node_index)++;
-            children.push_back({child_json, root_index, node_index});
+            const auto &children_json = node_json.at("children");
+
+            node.first_child = node_jsons.size();
+            node.child_count = children_json.size();
+            for (const auto &child_json : children_json)
+            {
+                node_jsons.push_back(&child_json);
+
+                if (child_json.at("type") == "response")
+                {
+                    node.has_response_nodes = true;
+                }
+            }
         }
+
+        nodes.push_back(std::move(node));
     }
-}
 
-bool ch::conversation::has_response_nodes() const
-{
-    return std::any_of(
-        children.begin(),
-        children.end(),
-        [](const auto &child)
+    // ids can point forwards, so jumps are resolved once every node is in
+    for (std::size_t node_index = 0; node_index < nodes.size(); node_index++)
+    {
+        const auto &jump_id = jump_ids.at(node_index);
+        if (jump_id.empty())
         {
-            return child.type == ch::conversation_type::response;
-        });
-}
+            continue;
+        }
 
-bool ch::conversation::check_conditions(const ch::player &player) const
-{
-    if (condition.quest_status)
-    {
-        if (!player.check_quest_status(*condition.quest_status))
+        const auto jump_node_index = node_indices.find(jump_id);
+        if (jump_node_index == node_indices.end())
         {
-            return false;
+            throw std::runtime_error("Failed to resolve conversation jump to " + jump_id);
         }
-    }
 
-    return true;
+        nodes.at(node_index).jump_index = jump_node_index->second;
+    }
 }
 
-const ch::conversation *ch::conversation::find_by_node_index(const std::size_t index) const
+const ch::conversation_node &ch::conversation::get_root() const
 {
-    if (node_index == index)
-    {
-        return this;
-    }
+    return nodes.front();
+}
 
-    for (const auto &child : children)
-    {
-        const auto child_ptr = child.find_by_node_index(index);
-        if (child_ptr)
-        {
-            return child_ptr;
-        }
-    }
+std::span<const ch::conversation_node> ch::conversation::get_children(const ch::conversation_node &node) const
+{
+    return std::span(nodes).subspan(node.first_child, node.child_count);
+}
 
-    return nullptr;
+const ch::conversation_node *ch::conversation::find_by_node_index(const std::size_t index) const
+{
+    return index < nodes.size() ? &nodes.at(index) : nullptr;
 }
 
-const ch::conversation *ch::conversation::find_by_id(const std::string &id_to_find) const
+const ch::conversation_node *ch::conversation::find_by_id(const std::string &id_to_find) const
 {
-    if (!id.empty() && id == id_to_find)
-    {
-        return this;
-    }
+    const auto node_index = node_indices.find(id_to_find);
+    return node_index != node_indices.end() ? &nodes.at(node_index->second) : nullptr;
+}
 
-    for (const auto &child : children)
+bool ch::conversation_node::check_conditions(const ch::player &player) const
+{
+    if (condition.quest_status)
     {
-        const auto child_ptr = child.find_by_id(id_to_find);
-        if (child_ptr)
+        if (!player.check_quest_status(*condition.quest_status))
         {
-            return child_ptr;
+            return false;
         }
     }
 
-    return nullptr;
+    return true;
 }
@@ -0,0 +1,216 @@
+#include <ch/coordinator.hpp>
+
+#include <ch/deserializer.hpp>
+#include <ch/host.hpp>
+#include <enet/enet.h>
+#include <spdlog/spdlog.h>
+
+ch::coordinator::coordinator(const std::uint16_t port)
+{
+    // zones run on the same machine, so only listen on loopback
+    ENetAddress address;
+    enet_address_set_host(&address, "127.0.0.1");
+    address.port = port;
+    host = std::make_unique<ch::host>(&address, max_zones, ch::channel_count, 0, 0);
+
+    zones.resize(max_zones);
+
+    spdlog::info("[Coordinator] Listening on port {}", port);
+}
+
+ch::coordinator::~coordinator()
+{
+    for (std::size_t i = 0; i < zones.size(); i++)
+    {
+        if (zones.at(i).registered)
+        {
+            enet_peer_disconnect_now(host->get_peer(i), 0);
+        }
+    }
+}
+
+void ch::coordinator::update(const std::uint32_t timeout)
+{
+    ENetEvent event;
+    if (host->service(&event, timeout) <= 0)
+    {
+        return;
+    }
+
+    do
+    {
+        const std::size_t peer_id = event.peer->incomingPeerID;
+
+        switch (event.type)
+        {
+        case ENET_EVENT_TYPE_CONNECT:
+        {
+            spdlog::info("[Coordinator] Zone connected from {}:{}", event.peer->address.host, event.peer->address.port);
+        }
+        break;
+        case ENET_EVENT_TYPE_RECEIVE:
+        {
+            ch::deserializer packet_deserializer(event.packet->data, event.packet->dataLength);
+            while (!packet_deserializer.is_at_end())
+            {
+                auto deserializer = packet_deserializer.read_frame();
+                if (!packet_deserializer.is_valid())
+                {
+                    spdlog::warn("[Coordinator] Malformed packet from zone {}", peer_id);
+                    break;
+                }
+
+                handle_message(peer_id, deserializer);
+            }
+
+            enet_packet_destroy(event.packet);
+        }
+        break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+        {
+            auto &zone = zones.at(peer_id);
+
+            spdlog::info("[Coordinator] Zone on port {} disconnected", zone.port);
+
+            for (const auto map_index : zone.map_indices)
+            {
+                const auto owner = map_owners.find(map_index);
+                if (owner != map_owners.end() && owner->second == peer_id)
+                {
+                    map_owners.erase(owner);
+                }
+            }
+
+            std::erase_if(
+                handoffs,
+                [peer_id](const auto &entry)
+                {
+                    return entry.second == peer_id;
+                });
+
+            zone = {};
+        }
+        break;
+        default:
+        {
+        }
+        break;
+        }
+    } while (host->service(&event, 0) > 0);
+}
+
+void ch::coordinator::handle_message(const std::size_t peer_id, ch::deserializer &deserializer)
+{
+    const auto type = static_cast<ch::message_type>(deserializer.peek_u8());
+
+    switch (type)
+    {
+    case ch::message_type::zone_register:
+    {
+        ch::message_zone_register message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        auto &zone = zones.at(peer_id);
+        zone.registered = true;
+        zone.port = message.port;
+
+        for (const auto map_index : message.map_indices)
+        {
+            if (map_owners.contains(map_index))
+            {
+                spdlog::warn("[Coordinator] Map {} is already owned, ignoring zone on port {}", map_index, message.port);
+                continue;
+            }
+
+            map_owners[map_index] = peer_id;
+            zone.map_indices.push_back(map_index);
+        }
+
+        spdlog::info("[Coordinator] Zone on port {} owns {} maps", zone.port, zone.map_indices.size());
+    }
+    break;
+    case ch::message_type::handoff:
+    {
+        ch::message_handoff message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        const auto owner = map_owners.find(message.map_index);
+        if (owner == map_owners.end() || owner->second == peer_id)
+        {
+            spdlog::warn("[Coordinator] No zone owns map {}", message.map_index);
+
+            ch::message_token reply;
+            reply.type = ch::message_type::handoff_rejected;
+            reply.token = message.token;
+            send(peer_id, reply);
+
+            break;
+        }
+
+        handoffs[message.token] = peer_id;
+        send(owner->second, message);
+    }
+    break;
+    case ch::message_type::handoff_accepted:
+    {
+        ch::message_redirect message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        const auto source = handoffs.find(message.token);
+        if (source == handoffs.end())
+        {
+            break;
+        }
+
+        send(source->second, message);
+        handoffs.erase(source);
+    }
+    break;
+    case ch::message_type::handoff_rejected:
+    {
+        ch::message_token message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        const auto source = handoffs.find(message.token);
+        if (source == handoffs.end())
+        {
+            break;
+        }
+
+        send(source->second, message);
+        handoffs.erase(source);
+    }
+    break;
+    default:
+    {
+        spdlog::warn("[Coordinator] Unknown message type {} from zone {}", static_cast<int>(type), peer_id);
+    }
+    break;
+    }
+
+    if (!deserializer.is_valid())
+    {
+        spdlog::warn("[Coordinator] Malformed message of type {} from zone {}", static_cast<int>(type), peer_id);
+    }
+}
+
+void ch::coordinator::send(const std::size_t peer_id, const std::vector<std::uint8_t> &message, const ch::channel channel)
+{
+    host->send(host->get_peer(peer_id), channel, ch::create_message_packet(packet_pool, message, channel));
+}
@@ -0,0 +1,113 @@
+#include <ch/deserializer.hpp>
+
+#include <bit>
+
+ch::deserializer::deserializer(const std::uint8_t *const data, const std::size_t length)
+    : data(data),
+      length(length)
+{
+}
+
+std::uint8_t ch::deserializer::peek_u8()
+{
+    if (offset >= length)
+    {
+        valid = false;
+        return 0;
+    }
+
+    return data[offset];
+}
+
+std::uint8_t ch::deserializer::read_u8()
+{
+    if (offset >= length)
+    {
+        valid = false;
+        return 0;
+    }
+
+    return data[offset++];
+}
+
+bool ch::deserializer::read_bool()
+{
+    return read_u8() != 0;
+}
+
+std::uint64_t ch::deserializer::read_varint()
+{
+    std::uint64_t value = 0;
+    for (std::size_t shift = 0; shift < 64; shift += 7)
+    {
+        const auto byte = read_u8();
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            return value;
+        }
+    }
+
+    valid = false;
+    return 0;
+}
+
+float ch::deserializer::read_f32()
+{
+    std::uint32_t bits = 0;
+    for (std::size_t shift = 0; shift < 32; shift += 8)
+    {
+        bits |= static_cast<std::uint32_t>(read_u8()) << shift;
+    }
+
+    return std::bit_cast<float>(bits);
+}
+
+float ch::deserializer::read_quantized(const float min, const float max)
+{
+    const auto low = read_u8();
+    const auto high = read_u8();
+    const auto quantized = static_cast<std::uint16_t>(low | (high << 8));
+
+    return min + (static_cast<float>(quantized) / UINT16_MAX) * (max - min);
+}
+
+ch::deserializer ch::deserializer::read_frame()
+{
+    const auto frame_length = read_varint();
+    if (!valid || frame_length > length - offset)
+    {
+        valid = false;
+        return {nullptr, 0};
+    }
+
+    const ch::deserializer frame(data + offset, frame_length);
+    offset += frame_length;
+
+    return frame;
+}
+
+std::size_t ch::deserializer::get_length() const
+{
+    return length;
+}
+
+std::size_t ch::deserializer::get_offset() const
+{
+    return offset;
+}
+
+bool ch::deserializer::is_at_end() const
+{
+    return offset >= length;
+}
+
+bool ch::deserializer::is_valid() const
+{
+    return valid;
+}
+
+void ch::deserializer::invalidate()
+{
+    valid = false;
+}
@@ -5,7 +5,11 @@
 
 ch::enet::enet()
 {
-    if (enet_initialize() != 0)
+    ENetCallbacks callbacks = {};
+    callbacks.malloc = &ch::pool_allocator::allocate;
+    callbacks.free = &ch::pool_allocator::deallocate;
+
+    if (enet_initialize_with_callbacks(ENET_VERSION, &callbacks) != 0)
     {
         throw std::runtime_error("Failed to initialize ENet");
     }
@@ -15,3 +19,8 @@ ch::enet::~enet()
 {
     enet_deinitialize();
 }
+
+ch::allocation_stats ch::enet::get_allocation_stats()
+{
+    return ch::pool_allocator::get_stats();
+}
@@ -27,12 +27,73 @@ ENetHost *ch::host::get_enet_host() const
     return enet_host;
 }
 
-void ch::host::broadcast(ENetPacket *const packet) const
+ENetPeer *ch::host::get_peer(const std::size_t peer_id) const
 {
-    enet_host_broadcast(enet_host, 0, packet);
+    return &enet_host->peers[peer_id];
+}
+
+std::size_t ch::host::get_connected_peer_count() const
+{
+    std::lock_guard lock(mutex);
+    return enet_host->connectedPeers;
+}
+
+ch::peer_sample ch::host::sample_peer(const std::size_t peer_id) const
+{
+    std::lock_guard lock(mutex);
+
+    auto &peer = enet_host->peers[peer_id];
+
+    return {
+        .round_trip_time = peer.roundTripTime,
+        .packet_loss = static_cast<float>(peer.packetLoss) / ENET_PEER_PACKET_LOSS_SCALE,
+        .packet_throttle = static_cast<float>(peer.packetThrottle) / ENET_PEER_PACKET_THROTTLE_SCALE,
+        .outgoing_queue_size = enet_list_size(&peer.outgoingCommands)};
+}
+
+void ch::host::broadcast(const ch::channel channel, ENetPacket *const packet) const
+{
+    std::lock_guard lock(mutex);
+    enet_host_broadcast(enet_host, static_cast<enet_uint8>(channel), packet);
+}
+
+int ch::host::send(ENetPeer *const peer, const ch::channel channel, ENetPacket *const packet) const
+{
+    std::lock_guard lock(mutex);
+
+    const auto result = enet_peer_send(peer, static_cast<enet_uint8>(channel), packet);
+    ch::release_unsent_packet(packet);
+    return result;
+}
+
+void ch::host::multicast(const std::vector<std::size_t> &peer_ids, const ch::channel channel, ENetPacket *const packet) const
+{
+    // held throughout, the listen thread could otherwise free the packet between sends
+    std::lock_guard lock(mutex);
+
+    for (const auto peer_id : peer_ids)
+    {
+        enet_peer_send(&enet_host->peers[peer_id], static_cast<enet_uint8>(channel), packet);
+    }
+
+    ch::release_unsent_packet(packet);
 }
 
 int ch::host::service(ENetEvent *const event, const std::uint32_t timeout) const
 {
+    std::lock_guard lock(mutex);
     return enet_host_service(enet_host, event, timeout);
 }
+
+void ch::host::flush() const
+{
+    std::lock_guard lock(mutex);
+    enet_host_flush(enet_host);
+}
+
+void ch::host::wait(const std::uint32_t timeout) const
+{
+    // the socket never changes, and waiting on it doesn't touch anything else ENet owns
+    enet_uint32 condition = ENET_SOCKET_WAIT_RECEIVE | ENET_SOCKET_WAIT_INTERRUPT;
+    enet_socket_wait(enet_host->socket, &condition, timeout);
+}
@@ -1,6 +1,7 @@
 #include <ch/map.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <ch/tileset.hpp>
 #include <ch/world.hpp>
 #include <spdlog/spdlog.h>
@@ -94,6 +95,19 @@ bool ch::map::is_solid(const std::size_t x, const std::size_t y) const
     return layer != layers.end();
 }
 
+bool ch::map::is_solid_at(const float x, const float y) const
+{
+    // solid tile bodies are centered on their tile's origin rather than its middle
+    const auto tile_x = std::floor(x / tile_width + 0.5f);
+    const auto tile_y = std::floor(y / tile_height + 0.5f);
+    if (tile_x < 0 || tile_y < 0)
+    {
+        return false;
+    }
+
+    return is_solid(static_cast<std::size_t>(tile_x), static_cast<std::size_t>(tile_y));
+}
+
 void ch::map::update(const float delta_time)
 {
     constexpr auto physics_delta_time = 1.0f / 60.0f;
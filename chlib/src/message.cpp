@@ -0,0 +1,322 @@
+#include <ch/message.hpp>
+
+#include <algorithm>
+
+void ch::message::write(ch::serializer &serializer) const
+{
+    serializer.write_u8(static_cast<std::uint8_t>(type));
+}
+
+void ch::message::read(ch::deserializer &deserializer)
+{
+    type = static_cast<ch::message_type>(deserializer.read_u8());
+}
+
+void ch::message_id::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(id);
+}
+
+void ch::message_id::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    id = deserializer.read_varint();
+}
+
+void ch::message_joined::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(id);
+    serializer.write_varint(resume_token);
+    serializer.write_bool(resumed);
+}
+
+void ch::message_joined::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    id = deserializer.read_varint();
+    resume_token = deserializer.read_varint();
+    resumed = deserializer.read_bool();
+}
+
+void ch::message_world_state::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(players.size());
+    for (const auto &player : players)
+    {
+        serializer.write_varint(player.id);
+        serializer.write_varint(player.quest_statuses.size());
+        for (const auto &status : player.quest_statuses)
+        {
+            serializer.write_varint(status.quest_index);
+            serializer.write_varint(status.stage_index);
+        }
+    }
+}
+
+void ch::message_world_state::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    const auto player_count = deserializer.read_varint();
+    players.clear();
+    for (std::size_t i = 0; i < player_count && deserializer.is_valid(); i++)
+    {
+        ch::world_state_player player;
+        player.id = deserializer.read_varint();
+        const auto quest_status_count = deserializer.read_varint();
+        for (std::size_t j = 0; j < quest_status_count && deserializer.is_valid(); j++)
+        {
+            ch::quest_status status;
+            status.quest_index = deserializer.read_varint();
+            status.stage_index = deserializer.read_varint();
+            player.quest_statuses.push_back(status);
+        }
+        players.push_back(std::move(player));
+    }
+}
+
+void ch::message_resume::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(resume_token);
+}
+
+void ch::message_resume::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    resume_token = deserializer.read_varint();
+}
+
+void ch::message_identify::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(player_key);
+}
+
+void ch::message_identify::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    player_key = deserializer.read_varint();
+}
+
+void ch::message_input::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(sequence);
+    serializer.write_u8(static_cast<std::uint8_t>(inputs.size()));
+    for (const auto &input : inputs)
+    {
+        serializer.write_u8(static_cast<std::uint8_t>((input.input_x + 1) | ((input.input_y + 1) << 2)));
+    }
+}
+
+void ch::message_input::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    sequence = static_cast<std::uint32_t>(deserializer.read_varint());
+
+    const auto count = deserializer.read_u8();
+    if (count == 0 || count > max_inputs || count > sequence)
+    {
+        deserializer.invalidate();
+        return;
+    }
+
+    inputs.resize(count);
+    for (auto &input : inputs)
+    {
+        const auto packed = deserializer.read_u8();
+        input.input_x = static_cast<std::int8_t>(std::clamp((packed & 0x3) - 1, -1, 1));
+        input.input_y = static_cast<std::int8_t>(std::clamp(((packed >> 2) & 0x3) - 1, -1, 1));
+    }
+}
+
+void ch::message_attack::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(view_tick);
+}
+
+void ch::message_attack::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    view_tick = deserializer.read_varint();
+}
+
+void ch::message_hit::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(attacker_id);
+    serializer.write_varint(target_id);
+}
+
+void ch::message_hit::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    attacker_id = deserializer.read_varint();
+    target_id = deserializer.read_varint();
+}
+
+void ch::message_quest_status::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(id);
+    serializer.write_varint(status.quest_index);
+    serializer.write_varint(status.stage_index);
+}
+
+void ch::message_quest_status::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    id = deserializer.read_varint();
+    status.quest_index = deserializer.read_varint();
+    status.stage_index = deserializer.read_varint();
+}
+
+void ch::message_conversation::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_bool(in_conversation);
+    if (in_conversation)
+    {
+        serializer.write_varint(root_index);
+        serializer.write_varint(node_index);
+    }
+}
+
+void ch::message_conversation::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    in_conversation = deserializer.read_bool();
+    root_index = in_conversation ? deserializer.read_varint() : 0;
+    node_index = in_conversation ? deserializer.read_varint() : 0;
+}
+
+void ch::message_sequence::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(sequence);
+}
+
+void ch::message_sequence::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    sequence = static_cast<std::uint32_t>(deserializer.read_varint());
+}
+
+void ch::message_game_state::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(tick);
+    serializer.write_varint(sequence);
+    serializer.write_varint(baseline_sequence);
+    serializer.write_varint(input_sequence);
+    serializer.write_varint(input_ticks);
+    serializer.write_varint(round_trip_time);
+    serializer.write_varint(player_count);
+}
+
+void ch::message_game_state::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    tick = deserializer.read_varint();
+    sequence = static_cast<std::uint32_t>(deserializer.read_varint());
+    baseline_sequence = static_cast<std::uint32_t>(deserializer.read_varint());
+    input_sequence = static_cast<std::uint32_t>(deserializer.read_varint());
+    input_ticks = static_cast<std::uint32_t>(deserializer.read_varint());
+    round_trip_time = static_cast<std::uint32_t>(deserializer.read_varint());
+    player_count = deserializer.read_varint();
+}
+
+void ch::message_redirect::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(port);
+    serializer.write_varint(token);
+}
+
+void ch::message_redirect::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    port = static_cast<std::uint16_t>(deserializer.read_varint());
+    token = static_cast<std::uint32_t>(deserializer.read_varint());
+}
+
+void ch::message_token::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(token);
+}
+
+void ch::message_token::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    token = static_cast<std::uint32_t>(deserializer.read_varint());
+}
+
+void ch::message_zone_register::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(port);
+    serializer.write_varint(map_indices.size());
+    for (const auto map_index : map_indices)
+    {
+        serializer.write_varint(map_index);
+    }
+}
+
+void ch::message_zone_register::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    port = static_cast<std::uint16_t>(deserializer.read_varint());
+    const auto map_count = deserializer.read_varint();
+    map_indices.clear();
+    for (std::size_t i = 0; i < map_count && deserializer.is_valid(); i++)
+    {
+        map_indices.push_back(deserializer.read_varint());
+    }
+}
+
+void ch::message_handoff::write(ch::serializer &serializer) const
+{
+    ch::message::write(serializer);
+    serializer.write_varint(token);
+    serializer.write_varint(map_index);
+    serializer.write_f32(position_x);
+    serializer.write_f32(position_y);
+    serializer.write_bool(in_conversation);
+    if (in_conversation)
+    {
+        serializer.write_varint(conversation_root_index);
+        serializer.write_varint(conversation_node_index);
+    }
+    serializer.write_varint(quest_statuses.size());
+    for (const auto &status : quest_statuses)
+    {
+        serializer.write_varint(status.quest_index);
+        serializer.write_varint(status.stage_index);
+    }
+}
+
+void ch::message_handoff::read(ch::deserializer &deserializer)
+{
+    ch::message::read(deserializer);
+    token = static_cast<std::uint32_t>(deserializer.read_varint());
+    map_index = deserializer.read_varint();
+    position_x = deserializer.read_f32();
+    position_y = deserializer.read_f32();
+    in_conversation = deserializer.read_bool();
+    conversation_root_index = in_conversation ? deserializer.read_varint() : 0;
+    conversation_node_index = in_conversation ? deserializer.read_varint() : 0;
+    const auto quest_status_count = deserializer.read_varint();
+    quest_statuses.clear();
+    for (std::size_t i = 0; i < quest_status_count && deserializer.is_valid(); i++)
+    {
+        ch::quest_status status;
+        status.quest_index = deserializer.read_varint();
+        status.stage_index = deserializer.read_varint();
+        quest_statuses.push_back(status);
+    }
+}
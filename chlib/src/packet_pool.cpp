@@ -0,0 +1,95 @@
+#include <ch/packet_pool.hpp>
+
+#include <enet/enet.h>
+#include <stdexcept>
+
+ch::packet_pool::~packet_pool() = default;
+
+std::vector<std::uint8_t> ch::packet_pool::acquire()
+{
+    std::lock_guard lock(mutex);
+
+    if (free_buffers.empty())
+    {
+        allocated_count++;
+        return {};
+    }
+
+    reused_count++;
+
+    auto buffer = std::move(free_buffers.back());
+    free_buffers.pop_back();
+    return buffer;
+}
+
+ENetPacket *ch::packet_pool::create_packet(std::vector<std::uint8_t> &&buffer, const std::uint32_t flags)
+{
+    std::unique_ptr<packet_buffer> packet_buffer;
+    {
+        std::lock_guard lock(mutex);
+
+        if (!free_packet_buffers.empty())
+        {
+            packet_buffer = std::move(free_packet_buffers.back());
+            free_packet_buffers.pop_back();
+        }
+    }
+    if (!packet_buffer)
+    {
+        packet_buffer = std::make_unique<ch::packet_pool::packet_buffer>();
+        packet_buffer->pool = this;
+    }
+
+    packet_buffer->data = std::move(buffer);
+
+    const auto packet = enet_packet_create(
+        packet_buffer->data.data(),
+        packet_buffer->data.size(),
+        flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+    if (!packet)
+    {
+        throw std::runtime_error("Failed to create ENet packet");
+    }
+
+    // owned by the packet until ENet frees it
+    packet->freeCallback = &ch::packet_pool::free_packet;
+    packet->userData = packet_buffer.release();
+
+    return packet;
+}
+
+std::size_t ch::packet_pool::get_reused_count() const
+{
+    std::lock_guard lock(mutex);
+    return reused_count;
+}
+
+std::size_t ch::packet_pool::get_allocated_count() const
+{
+    std::lock_guard lock(mutex);
+    return allocated_count;
+}
+
+void ch::packet_pool::free_packet(ENetPacket *const packet)
+{
+    std::unique_ptr<packet_buffer> packet_buffer(static_cast<ch::packet_pool::packet_buffer *>(packet->userData));
+    packet_buffer->pool->release(std::move(packet_buffer));
+}
+
+void ch::packet_pool::release(std::unique_ptr<packet_buffer> packet_buffer)
+{
+    std::lock_guard lock(mutex);
+
+    // past the cap the buffer is freed, so a burst doesn't pin its memory forever
+    if (free_buffers.size() < max_free_buffers)
+    {
+        packet_buffer->data.clear();
+        free_buffers.push_back(std::move(packet_buffer->data));
+    }
+    packet_buffer->data = {};
+
+    if (free_packet_buffers.size() < max_free_buffers)
+    {
+        free_packet_buffers.push_back(std::move(packet_buffer));
+    }
+}
@@ -1,4 +1,4 @@
-#include "peer.hpp"
+#include <ch/peer.hpp>
 
 #include <enet/enet.h>
 #include <stdexcept>
@@ -24,14 +24,22 @@ ch::peer::~peer()
     }
 }
 
-int ch::peer::send(ENetPacket *const packet) const
+ENetPeer *ch::peer::get_enet_peer() const
 {
-    return enet_peer_send(enet_peer, 0, packet);
+    return enet_peer;
+}
+
+int ch::peer::send(const ch::channel channel, ENetPacket *const packet) const
+{
+    // refused while a reconnect is still in progress, for one
+    const auto result = enet_peer_send(enet_peer, static_cast<enet_uint8>(channel), packet);
+    ch::release_unsent_packet(packet);
+    return result;
 }
 
 void ch::peer::disconnect() const
 {
-    enet_peer_disconnect(enet_peer, 0);
+    enet_peer_disconnect(enet_peer, leaving);
 }
 
 bool ch::peer::is_successfully_disconnected() const
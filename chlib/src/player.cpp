@@ -5,6 +5,21 @@
 #include <ch/tileset.hpp>
 #include <ch/world.hpp>
 
+b2Vec2 ch::player::get_velocity(const std::int8_t input_x, const std::int8_t input_y)
+{
+    constexpr auto speed = 100.0f;
+    auto velocity = b2Vec2(input_x * speed, input_y * speed);
+
+    const auto velocity_length = velocity.Length();
+    if (velocity_length > speed)
+    {
+        velocity.x *= (1 / velocity_length) * speed;
+        velocity.y *= (1 / velocity_length) * speed;
+    }
+
+    return velocity;
+}
+
 void ch::player::update(const float delta_time)
 {
     if (attacking)
@@ -50,17 +65,7 @@ void ch::player::update(const float delta_time)
         frame_index++;
     }
 
-    constexpr auto speed = 100.0f;
-    auto velocity = b2Vec2(input_x * speed, input_y * speed);
-
-    const auto velocity_length = velocity.Length();
-    if (velocity_length > speed)
-    {
-        velocity.x *= (1 / velocity_length) * speed;
-        velocity.y *= (1 / velocity_length) * speed;
-    }
-
-    body->SetLinearVelocity(velocity);
+    body->SetLinearVelocity(get_velocity(input_x, input_y));
 }
 
 void ch::player::attack()
@@ -71,26 +76,27 @@ void ch::player::attack()
 
 void ch::player::start_conversation(const std::shared_ptr<const ch::world> world, const std::size_t root_index)
 {
-    conversation_root = conversation_node = &world->conversations.at(root_index);
+    conversation_root = &world->conversations.at(root_index);
+    conversation_node = &conversation_root->get_root();
     advance_conversation();
 }
 
 void ch::player::advance_conversation()
 {
-    if (!conversation_node->jump_id.empty())
+    if (conversation_node->jump_index != ch::conversation_node::no_node)
     {
-        conversation_node = conversation_root->find_by_id(conversation_node->jump_id);
+        conversation_node = conversation_root->find_by_node_index(conversation_node->jump_index);
     }
     else
     {
-        if (!conversation_node->children.size())
+        if (!conversation_node->child_count)
         {
             return end_conversation();
         }
 
-        if (!conversation_node->has_response_nodes())
+        if (!conversation_node->has_response_nodes)
         {
-            for (const auto &child : conversation_node->children)
+            for (const auto &child : conversation_root->get_children(*conversation_node))
             {
                 if (child.check_conditions(*this))
                 {
@@ -111,7 +117,7 @@ void ch::player::advance_conversation()
 void ch::player::choose_conversation_response(const std::size_t choice_index)
 {
     std::size_t valid_choice_index = 0;
-    for (const auto &child : conversation_node->children)
+    for (const auto &child : conversation_root->get_children(*conversation_node))
     {
         if (child.type == ch::conversation_type::response && child.check_conditions(*this))
         {
@@ -128,7 +134,8 @@ void ch::player::choose_conversation_response(const std::size_t choice_index)
 
 void ch::player::end_conversation()
 {
-    conversation_root = conversation_node = nullptr;
+    conversation_root = nullptr;
+    conversation_node = nullptr;
 }
 
 void ch::player::set_quest_status(const ch::quest_status &status)
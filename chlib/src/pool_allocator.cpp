@@ -0,0 +1,198 @@
+#include <ch/pool_allocator.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+namespace
+{
+    struct alignas(std::max_align_t) block_header
+    {
+        std::size_t size_class;
+    };
+
+    // overlays the header while the block is free
+    struct free_block
+    {
+        free_block *next;
+    };
+
+    constexpr std::size_t large_size_class = ch::pool_allocator::size_class_count;
+
+    std::size_t get_size_class(const std::size_t size)
+    {
+        std::size_t size_class = 0;
+        for (auto block_size = ch::pool_allocator::min_block_size; block_size < size && size_class < large_size_class; block_size <<= 1)
+        {
+            size_class++;
+        }
+
+        return size_class;
+    }
+
+    struct free_list
+    {
+        free_block *head = nullptr;
+        std::size_t count = 0;
+
+        void push(free_block *const block)
+        {
+            block->next = head;
+            head = block;
+            count++;
+        }
+
+        free_block *pop()
+        {
+            const auto block = head;
+            head = block->next;
+            count--;
+            return block;
+        }
+
+        // moves up to block_count blocks onto the other list
+        void transfer(free_list &other, const std::size_t block_count)
+        {
+            for (std::size_t i = 0; i < block_count && head; i++)
+            {
+                other.push(pop());
+            }
+        }
+
+        void release()
+        {
+            while (head)
+            {
+                std::free(pop());
+            }
+        }
+    };
+
+    using free_lists = std::array<free_list, ch::pool_allocator::size_class_count>;
+
+    struct shared_pool
+    {
+        std::mutex mutex;
+        free_lists lists;
+
+        ~shared_pool()
+        {
+            for (auto &list : lists)
+            {
+                list.release();
+            }
+        }
+    };
+
+    shared_pool &get_shared_pool()
+    {
+        static shared_pool pool;
+        return pool;
+    }
+
+    struct thread_cache
+    {
+        free_lists lists;
+
+        // hand everything back when the thread exits, so other threads can still use it
+        ~thread_cache()
+        {
+            auto &pool = get_shared_pool();
+            std::lock_guard lock(pool.mutex);
+
+            for (std::size_t i = 0; i < lists.size(); i++)
+            {
+                lists.at(i).transfer(pool.lists.at(i), lists.at(i).count);
+            }
+        }
+    };
+
+    thread_local thread_cache cache;
+
+    std::atomic<std::uint64_t> allocations = 0;
+    std::atomic<std::uint64_t> frees = 0;
+    std::atomic<std::uint64_t> pooled_allocations = 0;
+    std::atomic<std::uint64_t> system_allocations = 0;
+
+    void *allocate_block(const std::size_t size_class, const std::size_t size)
+    {
+        system_allocations.fetch_add(1, std::memory_order_relaxed);
+
+        const auto header = static_cast<block_header *>(std::malloc(sizeof(block_header) + size));
+        if (!header)
+        {
+            return nullptr;
+        }
+
+        header->size_class = size_class;
+        return header + 1;
+    }
+}
+
+void *ch::pool_allocator::allocate(const std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    const auto size_class = get_size_class(size);
+    if (size_class == large_size_class)
+    {
+        return allocate_block(size_class, size);
+    }
+
+    auto &list = cache.lists.at(size_class);
+    if (!list.count)
+    {
+        auto &pool = get_shared_pool();
+        std::lock_guard lock(pool.mutex);
+        pool.lists.at(size_class).transfer(list, transfer_block_count);
+    }
+
+    if (!list.count)
+    {
+        return allocate_block(size_class, min_block_size << size_class);
+    }
+
+    pooled_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    const auto header = reinterpret_cast<block_header *>(list.pop());
+    header->size_class = size_class;
+    return header + 1;
+}
+
+void ch::pool_allocator::deallocate(void *const memory)
+{
+    if (!memory)
+    {
+        return;
+    }
+
+    frees.fetch_add(1, std::memory_order_relaxed);
+
+    const auto header = static_cast<block_header *>(memory) - 1;
+    const auto size_class = header->size_class;
+    if (size_class == large_size_class)
+    {
+        std::free(header);
+        return;
+    }
+
+    // blocks freed on another thread than they came from, like packets sent on the tick thread and freed by the listen thread, spill back through the shared list
+    auto &list = cache.lists.at(size_class);
+    list.push(reinterpret_cast<free_block *>(header));
+    if (list.count > max_cached_blocks)
+    {
+        auto &pool = get_shared_pool();
+        std::lock_guard lock(pool.mutex);
+        list.transfer(pool.lists.at(size_class), transfer_block_count);
+    }
+}
+
+ch::allocation_stats ch::pool_allocator::get_stats()
+{
+    return {
+        .allocations = allocations.load(std::memory_order_relaxed),
+        .frees = frees.load(std::memory_order_relaxed),
+        .pooled_allocations = pooled_allocations.load(std::memory_order_relaxed),
+        .system_allocations = system_allocations.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,26 @@
+#include <ch/position_history.hpp>
+
+void ch::position_history::record(
+    const std::uint64_t tick,
+    const std::size_t map_index,
+    const float position_x,
+    const float position_y)
+{
+    samples.at(tick % capacity) = {
+        .tick = tick,
+        .map_index = map_index,
+        .position_x = position_x,
+        .position_y = position_y};
+}
+
+const ch::position_sample *ch::position_history::find(const std::uint64_t tick) const
+{
+    // a slot left over from an older lap, or from before the player existed, doesn't count
+    const auto &sample = samples.at(tick % capacity);
+    return sample.tick == tick ? &sample : nullptr;
+}
+
+void ch::position_history::clear()
+{
+    samples = {};
+}
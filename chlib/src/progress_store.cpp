@@ -0,0 +1,332 @@
+#include <ch/progress_store.hpp>
+
+#include <algorithm>
+#include <ch/deserializer.hpp>
+#include <ch/serializer.hpp>
+#include <filesystem>
+#include <iterator>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    constexpr std::uint8_t journal_magic[] = {'C', 'H', 'P', 'J'};
+    constexpr std::uint8_t snapshot_magic[] = {'C', 'H', 'P', 'S'};
+    constexpr std::uint8_t version = 1;
+
+    // the contents after the header, which are empty if the file is missing
+    // returns false for a file that has contents but isn't ours, or is from another version
+    bool read_file(const std::string &filename, const std::uint8_t (&magic)[4], std::vector<std::uint8_t> &data)
+    {
+        data.clear();
+
+        std::ifstream file(filename, std::ios::binary);
+        if (!file)
+        {
+            return true;
+        }
+
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (data.empty())
+        {
+            return true;
+        }
+
+        if (data.size() < sizeof(magic) + 1 ||
+            !std::equal(std::begin(magic), std::end(magic), data.begin()) ||
+            data.at(sizeof(magic)) != version)
+        {
+            spdlog::error("[Server] Ignoring invalid progress file {}", filename);
+
+            data.clear();
+            return false;
+        }
+
+        data.erase(data.begin(), data.begin() + sizeof(magic) + 1);
+        return true;
+    }
+}
+
+ch::progress_store::progress_store(const std::string &filename)
+    : journal_filename(filename + ".journal"),
+      snapshot_filename(filename + ".snapshot"),
+      worker(&ch::progress_store::work, this)
+{
+}
+
+ch::progress_store::~progress_store()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    requests_available.notify_one();
+
+    // the worker drains every queued save before it returns
+    worker.join();
+}
+
+void ch::progress_store::save(const std::uint64_t player_key, const ch::quest_status &status)
+{
+    {
+        std::lock_guard lock(mutex);
+        requests.push_back({.load = false, .player_key = player_key, .status = status});
+    }
+    requests_available.notify_one();
+}
+
+void ch::progress_store::load(const std::uint64_t player_key, const std::size_t peer_id)
+{
+    {
+        std::lock_guard lock(mutex);
+        requests.push_back({.load = true, .player_key = player_key, .peer_id = peer_id});
+    }
+    requests_available.notify_one();
+}
+
+void ch::progress_store::poll(const std::function<void(const ch::progress_load &)> &on_load)
+{
+    std::vector<ch::progress_load> completed_loads;
+    {
+        std::lock_guard lock(loads_mutex);
+        completed_loads.swap(loads);
+    }
+
+    for (const auto &load : completed_loads)
+    {
+        on_load(load);
+    }
+}
+
+void ch::progress_store::work()
+{
+    // loads queued meanwhile simply wait for this
+    read_snapshot();
+    if (read_journal())
+    {
+        open_journal(false);
+    }
+    else
+    {
+        compact();
+    }
+
+    spdlog::info("[Server] Loaded progress of {} players", progress.size());
+
+    std::vector<request> batch;
+    std::vector<std::uint8_t> buffer;
+    std::vector<ch::progress_load> completed_loads;
+    while (true)
+    {
+        {
+            std::unique_lock lock(mutex);
+            requests_available.wait(
+                lock,
+                [this]()
+                {
+                    return !requests.empty() || stopping;
+                });
+
+            if (requests.empty())
+            {
+                break;
+            }
+
+            batch.swap(requests);
+        }
+
+        // everything saved since the last wakeup goes out in one write
+        buffer.clear();
+        ch::serializer serializer(buffer);
+        for (const auto &request : batch)
+        {
+            if (request.load)
+            {
+                const auto player_progress = progress.find(request.player_key);
+                completed_loads.push_back({
+                    .peer_id = request.peer_id,
+                    .player_key = request.player_key,
+                    .quest_statuses = player_progress != progress.end() ? player_progress->second : std::vector<ch::quest_status>{},
+                });
+            }
+            else
+            {
+                apply(request.player_key, request.status);
+
+                serializer.write_varint(request.player_key);
+                serializer.write_varint(request.status.quest_index);
+                serializer.write_varint(request.status.stage_index);
+                journal_record_count++;
+            }
+        }
+        batch.clear();
+
+        if (!buffer.empty())
+        {
+            journal.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+            journal.flush();
+        }
+
+        if (!completed_loads.empty())
+        {
+            std::lock_guard lock(loads_mutex);
+            loads.insert(loads.end(), completed_loads.begin(), completed_loads.end());
+            completed_loads.clear();
+        }
+
+        if (journal_record_count >= compaction_record_count)
+        {
+            compact();
+        }
+    }
+}
+
+void ch::progress_store::read_snapshot()
+{
+    std::vector<std::uint8_t> data;
+    read_file(snapshot_filename, snapshot_magic, data);
+    if (data.empty())
+    {
+        return;
+    }
+
+    ch::deserializer deserializer(data.data(), data.size());
+    const auto player_count = deserializer.read_varint();
+    for (std::size_t i = 0; i < player_count && deserializer.is_valid(); i++)
+    {
+        const auto player_key = deserializer.read_varint();
+        const auto quest_status_count = deserializer.read_varint();
+        for (std::size_t j = 0; j < quest_status_count && deserializer.is_valid(); j++)
+        {
+            ch::quest_status status;
+            status.quest_index = deserializer.read_varint();
+            status.stage_index = deserializer.read_varint();
+            apply(player_key, status);
+        }
+    }
+
+    // snapshots are replaced whole, so this is damage rather than a torn write
+    if (!deserializer.is_valid())
+    {
+        spdlog::error("[Server] Progress snapshot {} is malformed", snapshot_filename);
+    }
+}
+
+bool ch::progress_store::read_journal()
+{
+    // appending to a journal with a foreign header would lose every record after it
+    std::vector<std::uint8_t> data;
+    if (!read_file(journal_filename, journal_magic, data))
+    {
+        return false;
+    }
+
+    ch::deserializer deserializer(data.data(), data.size());
+    while (!deserializer.is_at_end())
+    {
+        const auto player_key = deserializer.read_varint();
+        ch::quest_status status;
+        status.quest_index = deserializer.read_varint();
+        status.stage_index = deserializer.read_varint();
+        if (!deserializer.is_valid())
+        {
+            // a write cut short by a crash, which later appends must not follow
+            spdlog::warn("[Server] Progress journal {} is truncated after {} records", journal_filename, journal_record_count);
+
+            return false;
+        }
+
+        apply(player_key, status);
+        journal_record_count++;
+    }
+
+    return true;
+}
+
+void ch::progress_store::open_journal(const bool truncate)
+{
+    std::error_code error;
+    const auto empty = truncate || !std::filesystem::exists(journal_filename, error) || std::filesystem::file_size(journal_filename, error) == 0;
+
+    journal.close();
+    journal.clear();
+    journal.open(journal_filename, std::ios::binary | (truncate ? std::ios::trunc : std::ios::app));
+    if (!journal)
+    {
+        spdlog::error("[Server] Failed to open progress journal {}", journal_filename);
+        return;
+    }
+
+    if (empty)
+    {
+        journal.write(reinterpret_cast<const char *>(journal_magic), sizeof(journal_magic));
+        journal.put(static_cast<char>(version));
+        journal.flush();
+    }
+}
+
+void ch::progress_store::compact()
+{
+    std::vector<std::uint8_t> buffer(std::begin(snapshot_magic), std::end(snapshot_magic));
+    buffer.push_back(version);
+
+    ch::serializer serializer(buffer);
+    serializer.write_varint(progress.size());
+    for (const auto &[player_key, quest_statuses] : progress)
+    {
+        serializer.write_varint(player_key);
+        serializer.write_varint(quest_statuses.size());
+        for (const auto &status : quest_statuses)
+        {
+            serializer.write_varint(status.quest_index);
+            serializer.write_varint(status.stage_index);
+        }
+    }
+
+    // written aside and renamed over the old snapshot, so a crash leaves one or the other intact
+    const auto temporary_filename = snapshot_filename + ".tmp";
+    {
+        std::ofstream file(temporary_filename, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        if (!file.flush())
+        {
+            spdlog::error("[Server] Failed to write progress snapshot {}", temporary_filename);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_filename, snapshot_filename, error);
+    if (error)
+    {
+        spdlog::error("[Server] Failed to replace progress snapshot {}: {}", snapshot_filename, error.message());
+        return;
+    }
+
+    // replaying the old journal over the new snapshot would be harmless, so a crash before this loses nothing
+    open_journal(true);
+    journal_record_count = 0;
+
+    spdlog::info("[Server] Compacted progress of {} players", progress.size());
+}
+
+void ch::progress_store::apply(const std::uint64_t player_key, const ch::quest_status &status)
+{
+    auto &quest_statuses = progress[player_key];
+
+    const auto quest_status = std::find_if(
+        quest_statuses.begin(),
+        quest_statuses.end(),
+        [status](const auto &quest_status)
+        {
+            return quest_status.quest_index == status.quest_index;
+        });
+
+    if (quest_status == quest_statuses.end())
+    {
+        quest_statuses.push_back(status);
+    }
+    else
+    {
+        quest_status->stage_index = status.stage_index;
+    }
+}
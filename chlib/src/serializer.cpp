@@ -0,0 +1,55 @@
+#include <ch/serializer.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+ch::serializer::serializer(std::vector<std::uint8_t> &buffer)
+    : buffer(buffer)
+{
+}
+
+void ch::serializer::write_u8(const std::uint8_t value)
+{
+    buffer.push_back(value);
+}
+
+void ch::serializer::write_bool(const bool value)
+{
+    write_u8(value ? 1 : 0);
+}
+
+void ch::serializer::write_varint(std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        write_u8(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+
+    write_u8(static_cast<std::uint8_t>(value));
+}
+
+void ch::serializer::write_f32(const float value)
+{
+    const auto bits = std::bit_cast<std::uint32_t>(value);
+    for (std::size_t shift = 0; shift < 32; shift += 8)
+    {
+        write_u8(static_cast<std::uint8_t>(bits >> shift));
+    }
+}
+
+void ch::serializer::write_quantized(const float value, const float min, const float max)
+{
+    const auto normalized = std::clamp((value - min) / (max - min), 0.0f, 1.0f);
+    const auto quantized = static_cast<std::uint16_t>(std::lround(normalized * UINT16_MAX));
+
+    write_u8(static_cast<std::uint8_t>(quantized));
+    write_u8(static_cast<std::uint8_t>(quantized >> 8));
+}
+
+void ch::serializer::write_frame(const std::vector<std::uint8_t> &message)
+{
+    write_varint(message.size());
+    buffer.insert(buffer.end(), message.begin(), message.end());
+}
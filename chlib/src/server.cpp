@@ -1,37 +1,248 @@
 #include <ch/server.hpp>
 
 #include <algorithm>
+#include <ch/batcher.hpp>
+#include <ch/channel.hpp>
+#include <ch/command_log.hpp>
 #include <ch/conversation.hpp>
 #include <ch/host.hpp>
 #include <ch/map.hpp>
+#include <ch/deserializer.hpp>
 #include <ch/message.hpp>
+#include <ch/peer.hpp>
+#include <ch/progress_store.hpp>
+#include <ch/serializer.hpp>
+#include <ch/snapshot.hpp>
+#include <ch/thread_pool.hpp>
 #include <ch/world.hpp>
+#include <ch/zone_link.hpp>
+#include <chrono>
+#include <cmath>
 #include <enet/enet.h>
+#include <numbers>
+#include <random>
 #include <spdlog/spdlog.h>
+#include <stdexcept>
+
+namespace
+{
+    // an input message also decodes to commands for the inputs it repeats, oldest first, into earlier_inputs
+    bool decode_command(ch::deserializer &deserializer, ch::command &command, std::vector<ch::command> &earlier_inputs)
+    {
+        const auto type = static_cast<ch::message_type>(deserializer.peek_u8());
+        earlier_inputs.clear();
+
+        switch (type)
+        {
+        case ch::message_type::resume:
+        {
+            ch::message_resume message;
+            message.read(deserializer);
+
+            command.type = ch::command_type::resume;
+            command.token = message.resume_token;
+        }
+        break;
+        case ch::message_type::identify:
+        {
+            ch::message_identify message;
+            message.read(deserializer);
+
+            command.type = ch::command_type::identify;
+            command.id = message.player_key;
+        }
+        break;
+        case ch::message_type::input:
+        {
+            ch::message_input message;
+            message.read(deserializer);
+            if (message.inputs.empty())
+            {
+                break;
+            }
+
+            command.type = ch::command_type::input;
+            for (std::size_t i = 0; i < message.inputs.size(); i++)
+            {
+                // the server drops the ones it already has by sequence
+                command.id = message.sequence - (message.inputs.size() - 1 - i);
+                command.input_x = message.inputs[i].input_x;
+                command.input_y = message.inputs[i].input_y;
+                if (i + 1 < message.inputs.size())
+                {
+                    earlier_inputs.push_back(command);
+                }
+            }
+        }
+        break;
+        case ch::message_type::attack:
+        {
+            ch::message_attack message;
+            message.read(deserializer);
+
+            command.type = ch::command_type::attack;
+            command.id = message.view_tick;
+        }
+        break;
+        case ch::message_type::change_map:
+        {
+            ch::message_id message;
+            message.read(deserializer);
+
+            command.type = ch::command_type::change_map;
+            command.id = message.id;
+        }
+        break;
+        case ch::message_type::start_conversation:
+        {
+            ch::message_id message;
+            message.read(deserializer);
+
+            command.type = ch::command_type::start_conversation;
+            command.id = message.id;
+        }
+        break;
+        case ch::message_type::advance_conversation:
+        {
+            ch::message message;
+            message.read(deserializer);
+
+            command.type = ch::command_type::advance_conversation;
+        }
+        break;
+        case ch::message_type::choose_conversation_response:
+        {
+            ch::message_id message;
+            message.read(deserializer);
+
+            command.type = ch::command_type::choose_conversation_response;
+            command.id = message.id;
+        }
+        break;
+        case ch::message_type::end_conversation:
+        {
+            ch::message message;
+            message.read(deserializer);
+
+            command.type = ch::command_type::end_conversation;
+        }
+        break;
+        case ch::message_type::quest_status:
+        {
+            ch::message_quest_status message;
+            message.read(deserializer);
+
+            command.type = ch::command_type::quest_status;
+            command.status = message.status;
+        }
+        break;
+        case ch::message_type::game_state_ack:
+        {
+            ch::message_sequence message;
+            message.read(deserializer);
+
+            command.type = ch::command_type::game_state_ack;
+            command.id = message.sequence;
+        }
+        break;
+        default:
+        {
+            spdlog::warn("[Server] Unknown message type {}", static_cast<int>(type));
+
+            return false;
+        }
+        break;
+        }
+
+        if (!deserializer.is_valid())
+        {
+            spdlog::warn("[Server] Malformed message of type {}", static_cast<int>(type));
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // tokens stand in for credentials, so they come from the system rather than a seeded generator anyone could follow
+    std::uint64_t generate_resume_token()
+    {
+        thread_local std::random_device random_device;
+
+        std::uint64_t token = 0;
+        while (!token)
+        {
+            token = (static_cast<std::uint64_t>(random_device()) << 32) | random_device();
+        }
+        return token;
+    }
+
+    // shares the connect data with fresh joins and resumes, so it skips their values
+    std::uint32_t generate_handoff_token()
+    {
+        thread_local std::random_device random_device;
+
+        std::uint32_t token = 0;
+        while (token <= ch::peer::resuming)
+        {
+            token = static_cast<std::uint32_t>(random_device());
+        }
+        return token;
+    }
+}
 
 ch::server::server(
     const std::uint16_t port,
-    const std::shared_ptr<ch::world> world)
-    : world(world)
+    const std::shared_ptr<ch::world> world,
+    const std::size_t max_players,
+    const float view_radius)
+    : server(world, max_players, view_radius)
 {
-    players.fill(
-        {.id = max_players});
+    this->port = port;
 
     ENetAddress address;
     address.host = ENET_HOST_ANY;
     address.port = port;
-    host = std::make_unique<ch::host>(&address, max_players, 2, 0, 0);
+    host = std::make_unique<ch::host>(&address, max_players, ch::channel_count, 0, 0);
+    batcher = std::make_unique<ch::batcher>(host.get(), packet_pool, max_players, network_stats);
 
     listening = true;
     listen_thread = std::thread(&ch::server::listen, this);
 
-    spdlog::info("[Server] Started on port {}", port);
+    spdlog::info("[Server] Started on port {} with capacity for {} players", port, max_players);
+}
+
+ch::server::server(
+    const std::shared_ptr<ch::world> world,
+    const std::size_t max_players,
+    const float view_radius)
+    : players(max_players),
+      world(world),
+      view_radius(view_radius),
+      listening(false),
+      peer_players(max_players),
+      resuming_peers(max_players),
+      connections(max_players)
+{
+    snapshots.resize(snapshot_history_size);
+    network_stats.peers.resize(max_players);
+    map_players.resize(world->maps.size());
+    owned_maps.resize(world->maps.size(), true);
+
+    // the calling thread simulates too, and there is never more work than one job per map
+    const auto thread_count = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), world->maps.size());
+    simulation_pool = std::make_unique<ch::thread_pool>(thread_count ? thread_count - 1 : 0);
+
+    batcher = std::make_unique<ch::batcher>(nullptr, packet_pool, max_players, network_stats);
 }
 
 ch::server::~server()
 {
-    listening = false;
-    listen_thread.join();
+    if (listen_thread.joinable())
+    {
+        listening = false;
+        listen_thread.join();
+    }
 
     spdlog::info("[Server] Successfully stopped");
 }
@@ -42,261 +253,1218 @@ void ch::server::handle_event(const SDL_Event &)
 
 void ch::server::update(const float delta_time)
 {
-    for (auto &player : players)
+    ch::command command;
+    while (commands.pop(command))
     {
-        if (player.id != max_players)
+        if (command_log)
         {
-            player.update(delta_time);
+            command_log->write({.tick = tick, .command = command});
         }
+
+        process_command(command);
+    }
+
+    if (progress_store)
+    {
+        progress_store->poll(
+            [this](const ch::progress_load &load)
+            {
+                restore_progress(load);
+            });
+    }
+
+    if (zone_link)
+    {
+        zone_link->poll(
+            [this](ch::deserializer &deserializer)
+            {
+                handle_zone_message(deserializer);
+            });
     }
 
-    world->update(delta_time);
+    expire_sessions();
+    expire_handoffs();
 
+    for (auto &players_on_map : map_players)
+    {
+        players_on_map.clear();
+    }
     for (auto &player : players)
     {
-        if (player.id != max_players)
+        map_players.at(player.map_index).push_back(&player);
+    }
+
+    // maps share no state, so each steps on its own and the pool returning is the barrier before snapshots
+    const auto simulation_start = std::chrono::steady_clock::now();
+    simulation_pool->run(
+        world->maps.size(),
+        [this, delta_time](const std::size_t map_index)
         {
-            const auto position = player.body->GetPosition();
+            const auto &players_on_map = map_players.at(map_index);
 
-            player.position_x = position.x;
-            player.position_y = position.y;
-        }
+            for (const auto player : players_on_map)
+            {
+                player->update(delta_time);
+            }
+
+            world->maps.at(map_index).update(delta_time);
+
+            for (const auto player : players_on_map)
+            {
+                const auto position = player->body->GetPosition();
+
+                player->position_x = position.x;
+                player->position_y = position.y;
+            }
+        });
+    simulation_time += std::chrono::steady_clock::now() - simulation_start;
+
+    send_world_state();
+    batcher->flush();
+    sample_network_stats();
+
+    if (command_log)
+    {
+        command_log->flush();
+    }
+
+    tick++;
+
+    // stamped with the tick the next snapshot will carry, which is what clients render
+    for (const auto &player : players)
+    {
+        connections.at(player.id).positions.record(tick, player.map_index, player.position_x, player.position_y);
+    }
+}
+
+void ch::server::send_game_state()
+{
+    if (command_log)
+    {
+        command_log->write({.tick = tick, .snapshot = true});
+    }
+
+    snapshot_sequence++;
+
+    auto &snapshot = snapshots.at(snapshot_sequence % snapshot_history_size);
+    snapshot.sequence = snapshot_sequence;
+    snapshot.tick = tick;
+    snapshot.players.resize(players.size());
+    std::size_t snapshot_index = 0;
+    for (const auto &player : players)
+    {
+        auto &snapshot_player = snapshot.players.at(snapshot_index++);
+
+        snapshot_player.id = player.id;
+
+        snapshot_player.map_index = player.map_index;
+
+        snapshot_player.position_x = player.position_x;
+        snapshot_player.position_y = player.position_y;
+
+        snapshot_player.direction = player.direction;
+        snapshot_player.animation = player.animation;
+        snapshot_player.frame_index = player.frame_index;
     }
 
+    // clients merge deltas by id
+    std::sort(
+        snapshot.players.begin(),
+        snapshot.players.end(),
+        [](const auto &a, const auto &b)
+        {
+            return a.id < b.id;
+        });
+
+    // each client gets an even share of the egress cap, and no more than its own link can take
+    const auto egress_share = max_snapshot_egress / std::max<std::size_t>(players.size(), 1);
+
+    const ch::snapshot empty_snapshot;
+    std::vector<std::uint8_t> buffer;
+    for (const auto &player : players)
     {
-        ch::message_game_state message;
-        message.type = ch::message_type::game_state;
-        for (std::size_t i = 0; i < players.size(); i++)
+        auto &connection = connections.at(player.id);
+        if (connection.suspended)
         {
-            message.players.at(i).id = players.at(i).id;
+            continue;
+        }
 
-            message.players.at(i).map_index = players.at(i).map_index;
+        auto &peer_stats = network_stats.peers.at(connection.peer_id);
 
-            message.players.at(i).position_x = players.at(i).position_x;
-            message.players.at(i).position_y = players.at(i).position_y;
+        // offline replays have no link to measure
+        const auto sample = host ? host->sample_peer(connection.peer_id) : ch::peer_sample{};
+        adapt_snapshot_rate(connection, sample);
 
-            message.players.at(i).direction = players.at(i).direction;
-            message.players.at(i).animation = players.at(i).animation;
-            message.players.at(i).frame_index = players.at(i).frame_index;
+        // credit builds up between snapshots, and an oversized snapshot is paid back by skipping the next ones
+        const auto credit_per_snapshot = std::min(connection.snapshot_budget, egress_share) / snapshot_rate;
+        connection.snapshot_credit = std::min(connection.snapshot_credit + credit_per_snapshot, credit_per_snapshot * max_snapshot_interval);
 
-            if (players.at(i).conversation_node)
-            {
-                message.players.at(i).in_conversation = true;
-                message.players.at(i).conversation_root_index = players.at(i).conversation_node->root_index;
-                message.players.at(i).conversation_node_index = players.at(i).conversation_node->node_index;
-            }
-            else
+        if (connection.snapshot_countdown > 0 || connection.snapshot_credit < 0)
+        {
+            if (connection.snapshot_countdown > 0)
             {
-                message.players.at(i).in_conversation = false;
+                connection.snapshot_countdown--;
             }
+
+            peer_stats.snapshots_skipped++;
+            continue;
         }
 
-        const auto packet = enet_packet_create(&message, sizeof(message), 0);
-        host->broadcast(packet);
+        connection.snapshot_countdown = connection.snapshot_interval - 1;
+
+        const auto visible_players = get_visible_players(snapshot, player.id);
+        connection.visible_players.at(snapshot_sequence % snapshot_history_size) = visible_players;
+
+        // fall back to a full snapshot if the client hasn't acked anything still in the history
+        const auto &acked_snapshot = snapshots.at(connection.acked_sequence % snapshot_history_size);
+        const auto baseline = connection.acked_sequence && acked_snapshot.sequence == connection.acked_sequence
+                                  ? acked_snapshot.filter(connection.visible_players.at(connection.acked_sequence % snapshot_history_size))
+                                  : empty_snapshot;
+
+        buffer.clear();
+        ch::serializer serializer(buffer);
+        snapshot.filter(visible_players).write(
+            baseline,
+            connection.input_sequence,
+            static_cast<std::uint32_t>(tick - connection.input_tick),
+            sample.round_trip_time,
+            *world,
+            serializer);
+
+        batcher->send(connection.peer_id, ch::channel::state, buffer);
+
+        connection.snapshot_credit -= static_cast<float>(buffer.size());
+        peer_stats.snapshots_sent++;
     }
+
+    batcher->flush();
 }
 
-void ch::server::listen()
+std::uint64_t ch::server::get_tick() const
 {
-    b2BodyDef body_def;
-    body_def.type = b2_dynamicBody;
-    body_def.position.Set(100.0f, 100.0f);
+    return tick;
+}
 
-    b2PolygonShape dynamicBox;
-    dynamicBox.SetAsBox(1.0f, 1.0f);
+std::chrono::steady_clock::duration ch::server::get_simulation_time() const
+{
+    return simulation_time;
+}
 
-    b2FixtureDef fixtureDef;
-    fixtureDef.shape = &dynamicBox;
-    fixtureDef.density = 1.0f;
-    fixtureDef.friction = 0.3f;
+void ch::server::start_zone(
+    const std::vector<std::size_t> &map_indices,
+    const char *const coordinator_hostname,
+    const std::uint16_t coordinator_port)
+{
+    if (map_indices.empty())
+    {
+        throw std::runtime_error("Failed to start zone: no maps");
+    }
 
-    while (listening)
+    std::fill(owned_maps.begin(), owned_maps.end(), false);
+    for (const auto map_index : map_indices)
     {
-        ENetEvent event;
-        while (host->service(&event, 0) > 0)
+        if (map_index >= owned_maps.size())
         {
-            switch (event.type)
-            {
-            case ENET_EVENT_TYPE_CONNECT:
-            {
-                spdlog::info("[Server] Player connected {}:{}", event.peer->address.host, event.peer->address.port);
+            throw std::runtime_error("Failed to start zone: invalid map");
+        }
 
-                const auto new_player = std::find_if(
-                    players.begin(),
-                    players.end(),
-                    [](const auto &player)
-                    {
-                        return player.id == max_players;
-                    });
-                if (new_player != players.end())
-                {
-                    new_player->id = std::distance(players.begin(), new_player);
-                    new_player->map_index = 0;
-                    new_player->body = world->maps.at(new_player->map_index).b2_world->CreateBody(&body_def);
-                    new_player->body->CreateFixture(&fixtureDef);
-                    new_player->on_quest_status_set = [this, new_player](const ch::quest_status &status)
-                    {
-                        spdlog::info("[Server] Player {} has advanced quest {} to stage {}", new_player->id, status.quest_index, status.stage_index);
+        owned_maps.at(map_index) = true;
+    }
+    spawn_map_index = map_indices.front();
 
-                        ch::message_quest_status message;
-                        message.type = ch::message_type::quest_status;
-                        message.id = new_player->id;
-                        message.status = status;
-                        const auto packet = enet_packet_create(&message, sizeof(message), ENET_PACKET_FLAG_RELIABLE);
-                        host->broadcast(packet);
-                    };
-                    event.peer->data = &*new_player;
+    zone_link = std::make_unique<ch::zone_link>(coordinator_hostname, coordinator_port, port, map_indices);
 
-                    spdlog::info("[Server] Assigned ID {}", new_player->id);
+    spdlog::info("[Server] Running as a zone for {} maps", map_indices.size());
+}
 
-                    {
-                        ch::message_id message;
-                        message.type = ch::message_type::server_joined;
-                        message.id = new_player->id;
-                        const auto packet = enet_packet_create(&message, sizeof(message), ENET_PACKET_FLAG_RELIABLE);
-                        enet_peer_send(event.peer, 0, packet);
-                    }
+void ch::server::start_persistence(const std::string &filename)
+{
+    progress_store = std::make_unique<ch::progress_store>(filename);
 
-                    for (const auto &player : players)
-                    {
-                        for (const auto &quest_status : player.quest_statuses)
-                        {
-                            ch::message_quest_status message;
-                            message.type = ch::message_type::quest_status;
-                            message.id = player.id;
-                            message.status = quest_status;
-                            const auto packet = enet_packet_create(&message, sizeof(message), ENET_PACKET_FLAG_RELIABLE);
-                            enet_peer_send(event.peer, 0, packet);
-                        }
-                    }
+    spdlog::info("[Server] Saving player progress to {}", filename);
+}
 
-                    {
-                        ch::message_id message;
-                        message.type = ch::message_type::player_connected;
-                        message.id = new_player->id;
-                        const auto packet = enet_packet_create(&message, sizeof(message), ENET_PACKET_FLAG_RELIABLE);
-                        host->broadcast(packet);
-                    }
-                }
-                else
-                {
-                    spdlog::warn("[Server] Player tried to join, but server is full");
+void ch::server::start_recording(const std::string &filename)
+{
+    command_log = std::make_unique<ch::command_log_writer>(filename);
 
-                    ch::message message;
-                    message.type = ch::message_type::server_full;
-                    const auto packet = enet_packet_create(&message, sizeof(message), ENET_PACKET_FLAG_RELIABLE);
-                    enet_peer_send(event.peer, 0, packet);
-                }
-            }
-            break;
-            case ENET_EVENT_TYPE_RECEIVE:
-            {
-                const auto player = static_cast<ch::player *>(event.peer->data);
-                const auto type = reinterpret_cast<ch::message *>(event.packet->data)->type;
+    spdlog::info("[Server] Recording commands to {}", filename);
+}
 
-                switch (type)
-                {
-                case ch::message_type::input:
-                {
-                    const auto message = reinterpret_cast<ch::message_input *>(event.packet->data);
+void ch::server::replay_command(const ch::command &command)
+{
+    if (command_log)
+    {
+        command_log->write({.tick = tick, .command = command});
+    }
 
-                    player->input_x = message->input_x;
-                    player->input_y = message->input_y;
-                }
-                break;
-                case ch::message_type::attack:
-                {
-                    spdlog::info("[Server] Player {} attacking", player->id);
+    process_command(command);
+}
 
-                    player->attack();
-                }
-                break;
-                case ch::message_type::change_map:
-                {
-                    const auto message = reinterpret_cast<ch::message_id *>(event.packet->data);
+const ch::network_stats &ch::server::get_network_stats() const
+{
+    return network_stats;
+}
 
-                    spdlog::info("[Server] Player {} changing map to {}", player->id, message->id);
+ch::network_stats ch::server::reset_network_stats()
+{
+    const auto stats = network_stats;
 
-                    world->maps.at(player->map_index).b2_world->DestroyBody(player->body);
-                    player->map_index = message->id;
-                    player->body = world->maps.at(player->map_index).b2_world->CreateBody(&body_def);
-                    player->body->CreateFixture(&fixtureDef);
-                }
-                break;
-                case ch::message_type::start_conversation:
-                {
-                    const auto message = reinterpret_cast<ch::message_id *>(event.packet->data);
+    network_stats = {};
+    network_stats.peers.resize(stats.peers.size());
 
-                    spdlog::info("[Server] Player {} starting conversation {}", player->id, message->id);
+    return stats;
+}
 
-                    player->start_conversation(world, message->id);
-                }
-                break;
-                case ch::message_type::advance_conversation:
-                {
-                    spdlog::info("[Server] Player {} advancing conversation", player->id);
+void ch::server::sample_network_stats()
+{
+    if (!host)
+    {
+        return;
+    }
 
-                    player->advance_conversation();
-                }
-                break;
-                case ch::message_type::choose_conversation_response:
-                {
-                    const auto message = reinterpret_cast<ch::message_id *>(event.packet->data);
+    for (const auto &player : players)
+    {
+        const auto &connection = connections.at(player.id);
+        if (connection.suspended)
+        {
+            continue;
+        }
 
-                    spdlog::info("[Server] Player {} choosing conversation response {}", player->id, message->id);
+        const auto peer_id = connection.peer_id;
+        const auto sample = host->sample_peer(peer_id);
 
-                    player->choose_conversation_response(message->id);
-                }
-                break;
-                case ch::message_type::end_conversation:
-                {
-                    spdlog::info("[Server] Player {} ending conversation", player->id);
+        auto &peer_stats = network_stats.peers.at(peer_id);
+        peer_stats.samples++;
+        peer_stats.total_round_trip_time += sample.round_trip_time;
+        peer_stats.max_round_trip_time = std::max(peer_stats.max_round_trip_time, sample.round_trip_time);
+        peer_stats.max_packet_loss = std::max(peer_stats.max_packet_loss, sample.packet_loss);
+        peer_stats.min_packet_throttle = std::min(peer_stats.min_packet_throttle, sample.packet_throttle);
+        peer_stats.max_outgoing_queue_size = std::max(peer_stats.max_outgoing_queue_size, sample.outgoing_queue_size);
+    }
+}
 
-                    player->end_conversation();
-                }
-                break;
-                case ch::message_type::quest_status:
-                {
-                    const auto message = reinterpret_cast<ch::message_quest_status *>(event.packet->data);
+void ch::server::adapt_snapshot_rate(connection &connection, const ch::peer_sample &sample) const
+{
+    if (!host)
+    {
+        return;
+    }
 
-                    spdlog::info("[Server] Player {} requesting to change quest {} to stage {}", player->id, message->status.quest_index, message->status.stage_index);
+    const auto congested = sample.round_trip_time > max_snapshot_round_trip_time ||
+                           sample.packet_loss > max_snapshot_packet_loss ||
+                           sample.packet_throttle < min_snapshot_packet_throttle ||
+                           sample.outgoing_queue_size > max_snapshot_outgoing_queue_size;
 
-                    player->set_quest_status(message->status);
-                }
-                break;
-                default:
-                {
-                    spdlog::warn("[Server] Unknown message type {}", static_cast<int>(type));
-                }
-                break;
-                }
+    connection.snapshots_since_backoff++;
 
-                enet_packet_destroy(event.packet);
-            }
-            break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-            {
-                const auto player = static_cast<ch::player *>(event.peer->data);
+    // back off quickly and recover slowly, giving ENet's own statistics time to catch up in between
+    if (congested)
+    {
+        connection.uncongested_snapshots = 0;
 
-                spdlog::info("[Server] Player {} disconnected", player->id);
+        if (connection.snapshots_since_backoff >= snapshot_backoff_delay)
+        {
+            connection.snapshot_interval = std::min(connection.snapshot_interval * 2, max_snapshot_interval);
+            connection.snapshot_budget = std::max(connection.snapshot_budget / 2, min_snapshot_budget);
+            connection.snapshots_since_backoff = 0;
+        }
+    }
+    else if (++connection.uncongested_snapshots >= snapshot_increase_delay)
+    {
+        connection.snapshot_interval = std::max(connection.snapshot_interval - 1, 1u);
+        connection.snapshot_budget = std::min(connection.snapshot_budget + min_snapshot_budget, max_snapshot_budget);
+        connection.uncongested_snapshots = 0;
+    }
+}
 
-                world->maps.at(player->map_index).b2_world->DestroyBody(player->body);
+void ch::server::resolve_attack(const ch::player &attacker, const std::uint64_t view_tick, const std::uint32_t round_trip_time)
+{
+    if (ch::player::weapon_item_index >= world->items.size())
+    {
+        return;
+    }
 
-                {
-                    ch::message_id message;
-                    message.type = ch::message_type::player_disconnected;
-                    message.id = player->id;
-                    const auto packet = enet_packet_create(&message, sizeof(message), ENET_PACKET_FLAG_RELIABLE);
-                    host->broadcast(packet);
-                }
+    // the attacker saw a snapshot half a round trip old, interpolated behind it, and the attack took the other half to get here
+    const auto measured_rewind_ticks = round_trip_time * std::uint64_t{tick_rate} / 1000 + interpolation_delay_ticks;
+    const auto measured_view_tick = tick > measured_rewind_ticks ? tick - measured_rewind_ticks : 0;
 
-                {
-                    player->id = max_players;
-                    event.peer->data = nullptr;
-                }
-            }
-            break;
-            }
+    // the client knows exactly what it saw, but only a claim close to the measurement is believed, or anyone could pick the past that suits them
+    const auto claim_error = view_tick > measured_view_tick ? view_tick - measured_view_tick : measured_view_tick - view_tick;
+    const auto trusted_view_tick = claim_error <= view_tick_tolerance_ticks ? view_tick : measured_view_tick;
+
+    // no further back than the history reaches
+    const auto oldest_tick = tick > max_rewind_ticks ? tick - max_rewind_ticks : 0;
+    const auto rewind_tick = std::clamp(trusted_view_tick, oldest_tick, tick);
+
+    const auto &weapon = world->items.at(ch::player::weapon_item_index);
+    const auto &attack_position = weapon.attack_positions.at(static_cast<std::size_t>(attacker.direction));
+
+    // the weapon sprite is rotated about its center, so use the bounds of the rotated box
+    const auto angle = attack_position.angle * std::numbers::pi_v<float> / 180;
+    const auto cos = std::abs(std::cos(angle));
+    const auto sin = std::abs(std::sin(angle));
+    const auto weapon_half_width = (weapon.width * cos + weapon.height * sin) / 2;
+    const auto weapon_half_height = (weapon.width * sin + weapon.height * cos) / 2;
+    const auto weapon_x = attacker.position_x + attack_position.x_offset + weapon.width / 2;
+    const auto weapon_y = attacker.position_y + attack_position.y_offset + weapon.height / 2;
+
+    constexpr auto target_half_size = ch::player::sprite_size / 2;
+
+    for (const auto &target : players)
+    {
+        if (target.id == attacker.id)
+        {
+            continue;
         }
-    }
+
+        const auto sample = connections.at(target.id).positions.find(rewind_tick);
+        if (!sample || sample->map_index != attacker.map_index)
+        {
+            continue;
+        }
+
+        const auto dx = std::abs(sample->position_x + target_half_size - weapon_x);
+        const auto dy = std::abs(sample->position_y + target_half_size - weapon_y);
+        if (dx > weapon_half_width + target_half_size || dy > weapon_half_height + target_half_size)
+        {
+            continue;
+        }
+
+        spdlog::info("[Server] Player {} hit player {} rewound {} ticks", attacker.id, target.id, tick - rewind_tick);
+
+        ch::message_hit message;
+        message.type = ch::message_type::player_hit;
+        message.attacker_id = attacker.id;
+        message.target_id = target.id;
+        broadcast_event(ch::serialize(message));
+    }
+}
+
+void ch::server::send_conversation(const ch::player &player)
+{
+    ch::message_conversation message;
+    message.type = ch::message_type::conversation;
+    message.in_conversation = player.conversation_node != nullptr;
+    message.root_index = player.conversation_node ? player.conversation_node->root_index : 0;
+    message.node_index = player.conversation_node ? player.conversation_node->node_index : 0;
+    batcher->send(connections.at(player.id).peer_id, message);
+}
+
+void ch::server::send_world_state()
+{
+    if (joining_peers.empty())
+    {
+        return;
+    }
+
+    // however many join at once, the state is built and serialized once and they share the packet
+    ch::message_world_state message;
+    message.type = ch::message_type::world_state;
+    message.players.reserve(players.size());
+    for (const auto &player : players)
+    {
+        message.players.push_back({.id = player.id, .quest_statuses = player.quest_statuses});
+    }
+    batcher->multicast(joining_peers, ch::get_channel(message.type), ch::serialize(message));
+
+    joining_peers.clear();
+}
+
+void ch::server::broadcast_event(const std::vector<std::uint8_t> &message)
+{
+    batcher->broadcast(ch::channel::events, message);
+
+    recent_events.push_back({.tick = tick, .message = message});
+    recent_event_bytes += message.size();
+
+    // a busy server would otherwise hold a minute of events, and replay all of them to every resuming client
+    while (recent_event_bytes > max_recent_event_bytes)
+    {
+        // others from the same tick may remain, but not all of them
+        recent_events_start_tick = std::max(recent_events_start_tick, recent_events.front().tick + 1);
+        recent_event_bytes -= recent_events.front().message.size();
+        recent_events.pop_front();
+    }
+}
+
+std::vector<std::size_t> ch::server::get_visible_players(const ch::snapshot &snapshot, const std::size_t viewer_id) const
+{
+    const auto &viewer = *snapshot.find(viewer_id);
+
+    std::vector<std::size_t> visible_players;
+    for (const auto &other : snapshot.players)
+    {
+        if (other.map_index == viewer.map_index)
+        {
+            const auto dx = other.position_x - viewer.position_x;
+            const auto dy = other.position_y - viewer.position_y;
+            if (dx * dx + dy * dy <= view_radius * view_radius)
+            {
+                visible_players.push_back(other.id);
+            }
+        }
+    }
+
+    return visible_players;
+}
+
+void ch::server::listen()
+{
+    std::vector<ch::command> earlier_inputs;
+    while (listening)
+    {
+        ENetEvent event;
+        while (host->service(&event, 0) > 0)
+        {
+            ch::command command;
+            command.peer_id = event.peer->incomingPeerID;
+
+            switch (event.type)
+            {
+            case ENET_EVENT_TYPE_CONNECT:
+            {
+                spdlog::info("[Server] Player connected {}:{}", event.peer->address.host, event.peer->address.port);
+
+                // a handoff token, ch::peer::resuming, or 0 for a fresh join
+                command.type = ch::command_type::connect;
+                command.id = event.data;
+                command.new_token = generate_resume_token();
+                command.address = event.peer->address.host;
+                push_command(command);
+            }
+            break;
+            case ENET_EVENT_TYPE_RECEIVE:
+            {
+                ch::deserializer packet_deserializer(event.packet->data, event.packet->dataLength);
+                while (!packet_deserializer.is_at_end())
+                {
+                    auto deserializer = packet_deserializer.read_frame();
+                    if (!packet_deserializer.is_valid())
+                    {
+                        spdlog::warn("[Server] Malformed packet from peer {}", command.peer_id);
+                        break;
+                    }
+
+                    if (decode_command(deserializer, command, earlier_inputs))
+                    {
+                        for (const auto &earlier_input : earlier_inputs)
+                        {
+                            push_command(earlier_input);
+                        }
+
+                        if (command.type == ch::command_type::resume)
+                        {
+                            command.new_token = generate_resume_token();
+                            command.address = event.peer->address.host;
+                        }
+
+                        // only this thread services the host, so the peer's measurement can't change under it
+                        if (command.type == ch::command_type::attack)
+                        {
+                            command.round_trip_time = event.peer->roundTripTime;
+                        }
+
+                        push_command(command);
+                    }
+                }
+
+                enet_packet_destroy(event.packet);
+            }
+            break;
+            case ENET_EVENT_TYPE_DISCONNECT:
+            {
+                // ch::peer::leaving, or 0 for a timeout
+                command.type = ch::command_type::disconnect;
+                command.id = event.data;
+                push_command(command);
+            }
+            break;
+            }
+        }
+
+        // ticks send their own packets, so only arrivals and ENet's timers need waking for
+        host->wait(listen_timeout);
+    }
+}
+
+void ch::server::push_command(const ch::command &command)
+{
+    // the tick thread drains the queue every tick, so a full queue only means waiting for the next one
+    while (!commands.push(command) && listening)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void ch::server::process_command(const ch::command &command)
+{
+    const auto player = players.get(peer_players.at(command.peer_id));
+
+    if (command.type != ch::command_type::connect && command.type != ch::command_type::resume && !player)
+    {
+        return;
+    }
+
+    if (!is_in_range(command))
+    {
+        spdlog::warn("[Server] Player {} sent out of range command of type {}", player->id, static_cast<int>(command.type));
+        return;
+    }
+
+    switch (command.type)
+    {
+    case ch::command_type::connect:
+    {
+        // a resuming peer joins once it has presented its token
+        resuming_peers.at(command.peer_id) = command.id == ch::peer::resuming;
+        if (!resuming_peers.at(command.peer_id))
+        {
+            join_player(command.peer_id, static_cast<std::uint32_t>(command.id), command.new_token, command.address);
+        }
+    }
+    break;
+    case ch::command_type::resume:
+    {
+        if (!resuming_peers.at(command.peer_id))
+        {
+            break;
+        }
+        resuming_peers.at(command.peer_id) = false;
+
+        const auto session = sessions.find(command.token);
+        if (session != sessions.end())
+        {
+            // a session still connected elsewhere can only be taken over from the same host
+            const auto &connection = connections.at(session->second.index);
+            if (connection.suspended || connection.address == command.address)
+            {
+                resume_session(command.peer_id, session->second, command.new_token, command.address);
+                break;
+            }
+
+            spdlog::warn("[Server] Refused to resume player {} from another host", session->second.index);
+        }
+
+        // an expired or refused session starts over as a new player
+        join_player(command.peer_id, 0, command.new_token, command.address);
+    }
+    break;
+    case ch::command_type::disconnect:
+    {
+        auto &connection = connections.at(player->id);
+        const auto handle = peer_players.at(command.peer_id);
+
+        batcher->clear(command.peer_id);
+        peer_players.at(command.peer_id) = {};
+        std::erase(joining_peers, command.peer_id);
+
+        // a dropped connection may come back, but not one that left or is moving to another zone
+        if (!command.id && !connection.handoff_token)
+        {
+            spdlog::info("[Server] Player {} timed out, holding their session", player->id);
+
+            connection.suspended = true;
+            connection.suspend_tick = tick;
+            player->input_x = 0;
+            player->input_y = 0;
+
+            break;
+        }
+
+        spdlog::info("[Server] Player {} disconnected", player->id);
+
+        remove_player(handle);
+    }
+    break;
+    case ch::command_type::identify:
+    {
+        auto &connection = connections.at(player->id);
+        if (!command.id || connection.player_key || connection.pending_player_key)
+        {
+            break;
+        }
+
+        spdlog::info("[Server] Player {} identified", player->id);
+
+        // progress is only saved under the key once what was saved before has been restored
+        if (progress_store)
+        {
+            connection.pending_player_key = command.id;
+            progress_store->load(command.id, command.peer_id);
+        }
+        else
+        {
+            connection.player_key = command.id;
+        }
+    }
+    break;
+    case ch::command_type::input:
+    {
+        // inputs are unreliable, so one overtaken by a newer one is stale
+        auto &connection = connections.at(player->id);
+        if (command.id > connection.input_sequence)
+        {
+            connection.input_sequence = static_cast<std::uint32_t>(command.id);
+            connection.input_tick = tick;
+
+            player->input_x = command.input_x;
+            player->input_y = command.input_y;
+        }
+    }
+    break;
+    case ch::command_type::attack:
+    {
+        // one swing at a time, however fast the client sends attacks
+        if (player->attacking)
+        {
+            break;
+        }
+
+        spdlog::info("[Server] Player {} attacking", player->id);
+
+        player->attack();
+        resolve_attack(*player, command.id, command.round_trip_time);
+    }
+    break;
+    case ch::command_type::change_map:
+    {
+        if (!owned_maps.at(command.id))
+        {
+            start_handoff(*player, command.id);
+            break;
+        }
+
+        spdlog::info("[Server] Player {} changing map to {}", player->id, command.id);
+
+        destroy_body(*player);
+        player->map_index = command.id;
+        create_body(*player, spawn_x, spawn_y);
+    }
+    break;
+    case ch::command_type::start_conversation:
+    {
+        spdlog::info("[Server] Player {} starting conversation {}", player->id, command.id);
+
+        player->start_conversation(world, command.id);
+        send_conversation(*player);
+    }
+    break;
+    case ch::command_type::advance_conversation:
+    {
+        // the client may not have seen the conversation end yet
+        if (!player->conversation_node)
+        {
+            break;
+        }
+
+        spdlog::info("[Server] Player {} advancing conversation", player->id);
+
+        player->advance_conversation();
+        send_conversation(*player);
+    }
+    break;
+    case ch::command_type::choose_conversation_response:
+    {
+        if (!player->conversation_node)
+        {
+            break;
+        }
+
+        spdlog::info("[Server] Player {} choosing conversation response {}", player->id, command.id);
+
+        player->choose_conversation_response(command.id);
+        send_conversation(*player);
+    }
+    break;
+    case ch::command_type::end_conversation:
+    {
+        spdlog::info("[Server] Player {} ending conversation", player->id);
+
+        player->end_conversation();
+        send_conversation(*player);
+    }
+    break;
+    case ch::command_type::quest_status:
+    {
+        spdlog::info("[Server] Player {} requesting to change quest {} to stage {}", player->id, command.status.quest_index, command.status.stage_index);
+
+        player->set_quest_status(command.status);
+    }
+    break;
+    case ch::command_type::game_state_ack:
+    {
+        auto &connection = connections.at(player->id);
+        if (command.id > connection.acked_sequence && command.id <= snapshot_sequence)
+        {
+            connection.acked_sequence = static_cast<std::uint32_t>(command.id);
+
+            const auto &acked_snapshot = snapshots.at(connection.acked_sequence % snapshot_history_size);
+            if (acked_snapshot.sequence == connection.acked_sequence)
+            {
+                connection.acked_tick = acked_snapshot.tick;
+            }
+        }
+    }
+    break;
+    }
+}
+
+bool ch::server::is_in_range(const ch::command &command) const
+{
+    switch (command.type)
+    {
+    case ch::command_type::change_map:
+    {
+        return command.id < world->maps.size();
+    }
+    break;
+    case ch::command_type::start_conversation:
+    {
+        return command.id < world->conversations.size();
+    }
+    break;
+    case ch::command_type::quest_status:
+    {
+        return command.status.quest_index < world->quests.size() &&
+               command.status.stage_index < world->quests.at(command.status.quest_index).stages.size();
+    }
+    break;
+    default:
+    {
+        return true;
+    }
+    break;
+    }
+}
+
+void ch::server::join_player(const std::size_t peer_id, const std::uint32_t handoff_token, const std::uint64_t resume_token, const std::uint32_t address)
+{
+    if (players.full())
+    {
+        spdlog::warn("[Server] Player tried to join, but server is full");
+
+        ch::message message;
+        message.type = ch::message_type::server_full;
+        batcher->send(peer_id, message);
+        return;
+    }
+
+    const auto handoff = pending_handoffs.find(handoff_token);
+
+    const auto handle = players.insert({});
+    const auto new_player = players.get(handle);
+    new_player->id = handle.index;
+    if (handoff != pending_handoffs.end())
+    {
+        const auto &message = handoff->second.message;
+
+        spdlog::info("[Server] Player handed off from another zone");
+
+        new_player->map_index = message.map_index;
+        create_body(*new_player, message.position_x, message.position_y);
+        new_player->quest_statuses = message.quest_statuses;
+        if (message.in_conversation && message.conversation_root_index < world->conversations.size())
+        {
+            // a node the root doesn't have leaves the player out of the conversation rather than half in it
+            const auto &conversation_root = world->conversations.at(message.conversation_root_index);
+            const auto conversation_node = conversation_root.find_by_node_index(message.conversation_node_index);
+            if (conversation_node)
+            {
+                new_player->conversation_root = &conversation_root;
+                new_player->conversation_node = conversation_node;
+            }
+        }
+
+        pending_handoffs.erase(handoff);
+    }
+    else
+    {
+        new_player->map_index = spawn_map_index;
+        create_body(*new_player, spawn_x, spawn_y);
+    }
+    new_player->on_quest_status_set = [this, id = new_player->id](const ch::quest_status &status)
+    {
+        spdlog::info("[Server] Player {} has advanced quest {} to stage {}", id, status.quest_index, status.stage_index);
+
+        // queued for the store's thread, never written from here
+        const auto player_key = connections.at(id).player_key;
+        if (progress_store && player_key)
+        {
+            progress_store->save(player_key, status);
+        }
+
+        ch::message_quest_status message;
+        message.type = ch::message_type::quest_status;
+        message.id = id;
+        message.status = status;
+        broadcast_event(ch::serialize(message));
+    };
+    peer_players.at(peer_id) = handle;
+    network_stats.peers.at(peer_id) = {};
+    auto &connection = connections.at(new_player->id);
+    connection = {};
+    connection.peer_id = peer_id;
+    connection.resume_token = resume_token;
+    connection.address = address;
+    sessions[connection.resume_token] = handle;
+
+    spdlog::info("[Server] Assigned ID {}", new_player->id);
+
+    {
+        ch::message_joined message;
+        message.type = ch::message_type::server_joined;
+        message.id = new_player->id;
+        message.resume_token = connection.resume_token;
+        message.resumed = false;
+        batcher->send(peer_id, message);
+    }
+
+    joining_peers.push_back(peer_id);
+
+    // a player handed off mid conversation carries on with it
+    if (new_player->conversation_node)
+    {
+        send_conversation(*new_player);
+    }
+
+    {
+        ch::message_id message;
+        message.type = ch::message_type::player_connected;
+        message.id = new_player->id;
+        broadcast_event(ch::serialize(message));
+    }
+}
+
+void ch::server::resume_session(const std::size_t peer_id, const ch::slot_handle handle, const std::uint64_t resume_token, const std::uint32_t address)
+{
+    const auto player = players.get(handle);
+    auto &connection = connections.at(player->id);
+
+    // the old connection may not have timed out here yet, and anything it still sends is ignored from now on
+    if (!connection.suspended)
+    {
+        batcher->clear(connection.peer_id);
+        peer_players.at(connection.peer_id) = {};
+        player->input_x = 0;
+        player->input_y = 0;
+    }
+
+    spdlog::info("[Server] Player {} resumed their session", player->id);
+
+    // tokens are single use
+    sessions.erase(connection.resume_token);
+    connection.resume_token = resume_token;
+    sessions[connection.resume_token] = handle;
+
+    // the new link is measured from scratch, but snapshot acks still hold, so deltas carry on from the client's history
+    connection.peer_id = peer_id;
+    connection.address = address;
+    connection.suspended = false;
+    connection.snapshot_interval = 1;
+    connection.snapshot_countdown = 0;
+    connection.snapshots_since_backoff = 0;
+    connection.uncongested_snapshots = 0;
+    connection.snapshot_budget = default_snapshot_budget;
+    connection.snapshot_credit = 0;
+    peer_players.at(peer_id) = handle;
+    network_stats.peers.at(peer_id) = {};
+
+    {
+        ch::message_joined message;
+        message.type = ch::message_type::server_joined;
+        message.id = player->id;
+        message.resume_token = connection.resume_token;
+        message.resumed = true;
+        batcher->send(peer_id, message);
+    }
+
+    // events the client may have missed, repeating a few it has is harmless since they set state
+    const auto catch_up_tick = connection.acked_tick > resume_catch_up_margin_ticks ? connection.acked_tick - resume_catch_up_margin_ticks : 0;
+    if (connection.acked_tick && catch_up_tick >= recent_events_start_tick)
+    {
+        for (const auto &event : recent_events)
+        {
+            if (event.tick >= catch_up_tick)
+            {
+                batcher->send(peer_id, ch::channel::events, event.message);
+            }
+        }
+    }
+    else
+    {
+        joining_peers.push_back(peer_id);
+    }
+
+    send_conversation(*player);
+
+    // a load answered while the player was away went to the old connection
+    if (progress_store && connection.pending_player_key)
+    {
+        progress_store->load(connection.pending_player_key, peer_id);
+    }
+}
+
+void ch::server::remove_player(const ch::slot_handle handle)
+{
+    const auto player = players.get(handle);
+
+    destroy_body(*player);
+
+    {
+        ch::message_id message;
+        message.type = ch::message_type::player_disconnected;
+        message.id = player->id;
+        broadcast_event(ch::serialize(message));
+    }
+
+    sessions.erase(connections.at(player->id).resume_token);
+    connections.at(player->id) = {};
+    players.erase(handle);
+}
+
+void ch::server::expire_sessions()
+{
+    std::vector<ch::slot_handle> expired_sessions;
+    for (const auto &[resume_token, handle] : sessions)
+    {
+        const auto &connection = connections.at(handle.index);
+        if (connection.suspended && connection.suspend_tick + resume_grace_ticks <= tick)
+        {
+            expired_sessions.push_back(handle);
+        }
+    }
+
+    for (const auto handle : expired_sessions)
+    {
+        spdlog::info("[Server] Player {} did not resume in time", handle.index);
+
+        remove_player(handle);
+    }
+
+    const auto oldest_event_tick = tick > recent_event_ticks ? tick - recent_event_ticks : 0;
+    while (!recent_events.empty() && recent_events.front().tick < oldest_event_tick)
+    {
+        recent_event_bytes -= recent_events.front().message.size();
+        recent_events.pop_front();
+    }
+    recent_events_start_tick = std::max(recent_events_start_tick, oldest_event_tick);
+}
+
+void ch::server::expire_handoffs()
+{
+    // the client never showed up at this zone
+    std::erase_if(
+        pending_handoffs,
+        [this](const auto &entry)
+        {
+            return entry.second.expiry_tick <= tick;
+        });
+
+    // the coordinator never answered, or the redirected client never left
+    for (const auto &player : players)
+    {
+        auto &connection = connections.at(player.id);
+        if (connection.handoff_token && connection.handoff_expiry_tick <= tick)
+        {
+            spdlog::warn("[Server] Handoff of player {} timed out, keeping them here", player.id);
+
+            connection.handoff_token = 0;
+        }
+    }
+}
+
+void ch::server::restore_progress(const ch::progress_load &load)
+{
+    // the player may have left, and someone else taken the slot, while the store was busy
+    const auto player = players.get(peer_players.at(load.peer_id));
+    if (!player || connections.at(player->id).pending_player_key != load.player_key)
+    {
+        return;
+    }
+
+    spdlog::info("[Server] Restoring {} quest statuses of player {}", load.quest_statuses.size(), player->id);
+
+    // anything advanced since joining, such as progress carried over in a handoff, is newer than what was saved
+    const auto session_quest_statuses = player->quest_statuses;
+    for (const auto &status : load.quest_statuses)
+    {
+        const auto advanced = std::any_of(
+            session_quest_statuses.begin(),
+            session_quest_statuses.end(),
+            [status](const auto &session_status)
+            {
+                return session_status.quest_index == status.quest_index;
+            });
+        if (advanced || status.quest_index >= world->quests.size())
+        {
+            continue;
+        }
+
+        // through the command path, so replays restore the same progress without the store
+        ch::command command;
+        command.type = ch::command_type::quest_status;
+        command.peer_id = load.peer_id;
+        command.status = status;
+        replay_command(command);
+    }
+
+    auto &connection = connections.at(player->id);
+    connection.player_key = load.player_key;
+    connection.pending_player_key = 0;
+
+    for (const auto &status : session_quest_statuses)
+    {
+        progress_store->save(connection.player_key, status);
+    }
+}
+
+void ch::server::handle_zone_message(ch::deserializer &deserializer)
+{
+    const auto type = static_cast<ch::message_type>(deserializer.peek_u8());
+
+    switch (type)
+    {
+    case ch::message_type::handoff:
+    {
+        ch::message_handoff message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        if (message.map_index >= world->maps.size() || !owned_maps.at(message.map_index))
+        {
+            ch::message_token reply;
+            reply.type = ch::message_type::handoff_rejected;
+            reply.token = message.token;
+            zone_link->send(reply);
+
+            break;
+        }
+
+        spdlog::info("[Server] Expecting handed off player on map {}", message.map_index);
+
+        pending_handoffs[message.token] = {.message = message, .expiry_tick = tick + handoff_timeout_ticks};
+
+        ch::message_redirect reply;
+        reply.type = ch::message_type::handoff_accepted;
+        reply.port = port;
+        reply.token = message.token;
+        zone_link->send(reply);
+    }
+    break;
+    case ch::message_type::handoff_accepted:
+    {
+        ch::message_redirect message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        for (const auto &player : players)
+        {
+            const auto &connection = connections.at(player.id);
+            if (connection.handoff_token == message.token)
+            {
+                spdlog::info("[Server] Redirecting player {} to zone on port {}", player.id, message.port);
+
+                // the client disconnects once it has the redirect, which removes the player here
+                message.type = ch::message_type::redirect;
+                batcher->send(connection.peer_id, message);
+
+                break;
+            }
+        }
+    }
+    break;
+    case ch::message_type::handoff_rejected:
+    {
+        ch::message_token message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        for (const auto &player : players)
+        {
+            auto &connection = connections.at(player.id);
+            if (connection.handoff_token == message.token)
+            {
+                spdlog::warn("[Server] Handoff of player {} was rejected", player.id);
+
+                connection.handoff_token = 0;
+
+                break;
+            }
+        }
+    }
+    break;
+    default:
+    {
+        spdlog::warn("[Server] Unknown message type {} from coordinator", static_cast<int>(type));
+    }
+    break;
+    }
+
+    if (!deserializer.is_valid())
+    {
+        spdlog::warn("[Server] Malformed message of type {} from coordinator", static_cast<int>(type));
+    }
+}
+
+void ch::server::start_handoff(ch::player &player, const std::size_t map_index)
+{
+    auto &connection = connections.at(player.id);
+
+    // waiting on the coordinator already, or there is no other zone to ask
+    if (!zone_link || connection.handoff_token)
+    {
+        spdlog::warn("[Server] Player {} requested map {} owned by another zone", player.id, map_index);
+        return;
+    }
+
+    connection.handoff_token = generate_handoff_token();
+    connection.handoff_expiry_tick = tick + handoff_timeout_ticks;
+
+    spdlog::info("[Server] Handing off player {} to the zone owning map {}", player.id, map_index);
+
+    ch::message_handoff message;
+    message.type = ch::message_type::handoff;
+    message.token = connection.handoff_token;
+    message.map_index = map_index;
+    message.position_x = spawn_x;
+    message.position_y = spawn_y;
+    message.in_conversation = player.conversation_node != nullptr;
+    message.conversation_root_index = player.conversation_node ? player.conversation_node->root_index : 0;
+    message.conversation_node_index = player.conversation_node ? player.conversation_node->node_index : 0;
+    message.quest_statuses = player.quest_statuses;
+    zone_link->send(message);
+}
+
+void ch::server::create_body(ch::player &player, const float x, const float y) const
+{
+    b2BodyDef body_def;
+    body_def.type = b2_dynamicBody;
+    body_def.position.Set(x, y);
+
+    b2PolygonShape shape;
+    shape.SetAsBox(1.0f, 1.0f);
+
+    b2FixtureDef fixture_def;
+    fixture_def.shape = &shape;
+    fixture_def.density = 1.0f;
+    fixture_def.friction = 0.3f;
+
+    player.body = world->maps.at(player.map_index).b2_world->CreateBody(&body_def);
+    player.body->CreateFixture(&fixture_def);
+}
+
+void ch::server::destroy_body(ch::player &player) const
+{
+    world->maps.at(player.map_index).b2_world->DestroyBody(player.body);
+    player.body = nullptr;
 }
@@ -0,0 +1,269 @@
+#include <ch/snapshot.hpp>
+
+#include <ch/deserializer.hpp>
+#include <ch/message.hpp>
+#include <ch/serializer.hpp>
+#include <ch/world.hpp>
+#include <algorithm>
+
+namespace
+{
+    std::uint8_t pack_state(const ch::snapshot_player &player)
+    {
+        return static_cast<std::uint8_t>(
+            static_cast<std::uint8_t>(player.direction) |
+            (static_cast<std::uint8_t>(player.animation) << 2));
+    }
+
+    bool unpack_state(const std::uint8_t state, ch::snapshot_player &player)
+    {
+        const auto animation = (state >> 2) & 0x3;
+        if (animation > static_cast<std::uint8_t>(ch::animation::attacking))
+        {
+            return false;
+        }
+
+        player.direction = static_cast<ch::direction>(state & 0x3);
+        player.animation = static_cast<ch::animation>(animation);
+
+        return true;
+    }
+
+    constexpr std::uint8_t required_fields =
+        ch::snapshot_field::map_index |
+        ch::snapshot_field::position |
+        ch::snapshot_field::state |
+        ch::snapshot_field::frame_index;
+
+    // walks both sorted player lists together, reporting every player that was added, changed or removed
+    template <typename F>
+    void for_each_change(const ch::snapshot &snapshot, const ch::snapshot &baseline, F &&on_change)
+    {
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (i < snapshot.players.size() || j < baseline.players.size())
+        {
+            if (j == baseline.players.size() || (i < snapshot.players.size() && snapshot.players.at(i).id < baseline.players.at(j).id))
+            {
+                const auto &player = snapshot.players.at(i++);
+                on_change(player.id, required_fields, player);
+            }
+            else if (i == snapshot.players.size() || baseline.players.at(j).id < snapshot.players.at(i).id)
+            {
+                const auto &player = baseline.players.at(j++);
+                on_change(player.id, ch::snapshot_field::removed, player);
+            }
+            else
+            {
+                const auto &player = snapshot.players.at(i++);
+                const auto fields = player.diff(baseline.players.at(j++));
+                if (fields)
+                {
+                    on_change(player.id, fields, player);
+                }
+            }
+        }
+    }
+}
+
+std::uint8_t ch::snapshot_player::diff(const ch::snapshot_player &baseline) const
+{
+    std::uint8_t fields = 0;
+    if (map_index != baseline.map_index)
+    {
+        fields |= ch::snapshot_field::map_index;
+    }
+    if (position_x != baseline.position_x || position_y != baseline.position_y)
+    {
+        fields |= ch::snapshot_field::position;
+    }
+    if (direction != baseline.direction || animation != baseline.animation)
+    {
+        fields |= ch::snapshot_field::state;
+    }
+    if (frame_index != baseline.frame_index)
+    {
+        fields |= ch::snapshot_field::frame_index;
+    }
+
+    return fields;
+}
+
+const ch::snapshot_player *ch::snapshot::find(const std::size_t id) const
+{
+    const auto player = std::lower_bound(
+        players.begin(),
+        players.end(),
+        id,
+        [](const auto &player, const std::size_t id)
+        {
+            return player.id < id;
+        });
+
+    return player != players.end() && player->id == id ? &*player : nullptr;
+}
+
+ch::snapshot ch::snapshot::filter(const std::vector<std::size_t> &visible_ids) const
+{
+    ch::snapshot filtered_snapshot;
+    filtered_snapshot.sequence = sequence;
+    filtered_snapshot.tick = tick;
+    filtered_snapshot.players.reserve(visible_ids.size());
+
+    // both lists are sorted by id
+    std::size_t i = 0;
+    for (const auto id : visible_ids)
+    {
+        while (i < players.size() && players.at(i).id < id)
+        {
+            i++;
+        }
+
+        if (i < players.size() && players.at(i).id == id)
+        {
+            filtered_snapshot.players.push_back(players.at(i));
+        }
+    }
+
+    return filtered_snapshot;
+}
+
+void ch::snapshot::write(
+    const ch::snapshot &baseline,
+    const std::uint32_t input_sequence,
+    const std::uint32_t input_ticks,
+    const std::uint32_t round_trip_time,
+    const ch::world &world,
+    ch::serializer &serializer) const
+{
+    ch::message_game_state message;
+    message.type = ch::message_type::game_state;
+    message.tick = tick;
+    message.sequence = sequence;
+    message.baseline_sequence = baseline.sequence;
+    message.input_sequence = input_sequence;
+    message.input_ticks = input_ticks;
+    message.round_trip_time = round_trip_time;
+    message.player_count = 0;
+    for_each_change(
+        *this,
+        baseline,
+        [&message](std::size_t, std::uint8_t, const ch::snapshot_player &)
+        {
+            message.player_count++;
+        });
+
+    message.write(serializer);
+
+    for_each_change(
+        *this,
+        baseline,
+        [&world, &serializer](const std::size_t id, const std::uint8_t fields, const ch::snapshot_player &player)
+        {
+            serializer.write_varint(id);
+            serializer.write_u8(fields);
+
+            if (fields & ch::snapshot_field::map_index)
+            {
+                serializer.write_varint(player.map_index);
+            }
+            if (fields & ch::snapshot_field::position)
+            {
+                const auto &map = world.maps.at(player.map_index);
+                serializer.write_quantized(player.position_x, 0, static_cast<float>(map.width * map.tile_width));
+                serializer.write_quantized(player.position_y, 0, static_cast<float>(map.height * map.tile_height));
+            }
+            if (fields & ch::snapshot_field::state)
+            {
+                serializer.write_u8(pack_state(player));
+            }
+            if (fields & ch::snapshot_field::frame_index)
+            {
+                serializer.write_varint(player.frame_index);
+            }
+        });
+}
+
+bool ch::snapshot::read(const ch::snapshot &baseline, const ch::message_game_state &message, const ch::world &world, ch::deserializer &deserializer)
+{
+    if (message.baseline_sequence != baseline.sequence)
+    {
+        return false;
+    }
+
+    // baseline may alias this snapshot, so merge into a fresh list
+    std::vector<ch::snapshot_player> merged_players;
+    merged_players.reserve(baseline.players.size() + message.player_count);
+
+    std::size_t baseline_index = 0;
+    std::size_t previous_id = 0;
+    for (std::size_t i = 0; i < message.player_count; i++)
+    {
+        const auto id = deserializer.read_varint();
+        const auto fields = deserializer.read_u8();
+        if (!deserializer.is_valid() || (i > 0 && id <= previous_id))
+        {
+            return false;
+        }
+        previous_id = id;
+
+        while (baseline_index < baseline.players.size() && baseline.players.at(baseline_index).id < id)
+        {
+            merged_players.push_back(baseline.players.at(baseline_index++));
+        }
+
+        ch::snapshot_player player;
+        if (baseline_index < baseline.players.size() && baseline.players.at(baseline_index).id == id)
+        {
+            player = baseline.players.at(baseline_index++);
+        }
+        else if (!(fields & ch::snapshot_field::removed) && (fields & required_fields) != required_fields)
+        {
+            // a player missing from the baseline has to be sent in full
+            return false;
+        }
+
+        if (fields & ch::snapshot_field::removed)
+        {
+            continue;
+        }
+
+        player.id = id;
+
+        if (fields & ch::snapshot_field::map_index)
+        {
+            player.map_index = deserializer.read_varint();
+            if (player.map_index >= world.maps.size())
+            {
+                return false;
+            }
+        }
+        if (fields & ch::snapshot_field::position)
+        {
+            const auto &map = world.maps.at(player.map_index);
+            player.position_x = deserializer.read_quantized(0, static_cast<float>(map.width * map.tile_width));
+            player.position_y = deserializer.read_quantized(0, static_cast<float>(map.height * map.tile_height));
+        }
+        if (fields & ch::snapshot_field::state)
+        {
+            if (!unpack_state(deserializer.read_u8(), player))
+            {
+                return false;
+            }
+        }
+        if (fields & ch::snapshot_field::frame_index)
+        {
+            player.frame_index = deserializer.read_varint();
+        }
+
+        merged_players.push_back(player);
+    }
+
+    merged_players.insert(merged_players.end(), baseline.players.begin() + baseline_index, baseline.players.end());
+
+    sequence = message.sequence;
+    tick = message.tick;
+    players = std::move(merged_players);
+
+    return deserializer.is_valid();
+}
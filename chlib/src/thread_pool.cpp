@@ -0,0 +1,108 @@
+#include <ch/thread_pool.hpp>
+
+ch::thread_pool::thread_pool(const std::size_t worker_count)
+{
+    for (std::size_t i = 0; i < worker_count; i++)
+    {
+        workers.emplace_back(&ch::thread_pool::work, this);
+    }
+}
+
+ch::thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+std::size_t ch::thread_pool::get_worker_count() const
+{
+    return workers.size();
+}
+
+void ch::thread_pool::run(const std::size_t job_count, const std::function<void(std::size_t)> &job)
+{
+    if (workers.empty() || job_count <= 1)
+    {
+        for (std::size_t i = 0; i < job_count; i++)
+        {
+            job(i);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        this->job = &job;
+        this->job_count = job_count;
+        next_job = 0;
+        active_workers = workers.size();
+        generation++;
+    }
+    work_available.notify_all();
+
+    run_jobs(job, job_count);
+
+    // every worker checks in once per run, so none can still be touching this job afterwards
+    std::unique_lock lock(mutex);
+    work_done.wait(
+        lock,
+        [this]()
+        {
+            return active_workers == 0;
+        });
+    this->job = nullptr;
+}
+
+void ch::thread_pool::work()
+{
+    std::uint64_t seen_generation = 0;
+
+    while (true)
+    {
+        const std::function<void(std::size_t)> *current_job;
+        std::size_t current_job_count;
+
+        {
+            std::unique_lock lock(mutex);
+            work_available.wait(
+                lock,
+                [this, seen_generation]()
+                {
+                    return stopping || generation != seen_generation;
+                });
+            if (stopping)
+            {
+                return;
+            }
+
+            seen_generation = generation;
+            current_job = job;
+            current_job_count = job_count;
+        }
+
+        run_jobs(*current_job, current_job_count);
+
+        {
+            std::lock_guard lock(mutex);
+            active_workers--;
+        }
+        work_done.notify_one();
+    }
+}
+
+void ch::thread_pool::run_jobs(const std::function<void(std::size_t)> &job, const std::size_t job_count)
+{
+    for (auto i = next_job++; i < job_count; i = next_job++)
+    {
+        job(i);
+    }
+}
@@ -0,0 +1,102 @@
+#include <ch/tick_scheduler.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+ch::tick_scheduler::tick_scheduler(
+    const std::uint32_t tick_rate,
+    const std::uint32_t snapshot_rate,
+    const std::size_t max_catch_up_ticks)
+    : max_catch_up_ticks(std::max<std::size_t>(max_catch_up_ticks, 1))
+{
+    if (!tick_rate || !snapshot_rate)
+    {
+        throw std::invalid_argument("Tick and snapshot rates must be non-zero");
+    }
+
+    tick_duration = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / tick_rate));
+    snapshot_interval = std::max<std::uint64_t>(tick_rate / snapshot_rate, 1);
+    next_tick_time = clock::now();
+}
+
+float ch::tick_scheduler::get_delta_time() const
+{
+    return std::chrono::duration<float>(tick_duration).count();
+}
+
+std::uint64_t ch::tick_scheduler::get_tick() const
+{
+    return tick;
+}
+
+const ch::tick_stats &ch::tick_scheduler::get_stats() const
+{
+    return stats;
+}
+
+ch::tick_stats ch::tick_scheduler::reset_stats()
+{
+    const auto previous_stats = stats;
+    stats = {};
+    return previous_stats;
+}
+
+void ch::tick_scheduler::update(
+    const std::function<void(float)> &on_tick,
+    const std::function<void()> &on_snapshot)
+{
+    const auto delta_time = get_delta_time();
+
+    bool snapshot_due = false;
+    std::size_t ticks_run = 0;
+    float budget_usage = 0;
+    auto now = clock::now();
+    while (now >= next_tick_time && ticks_run < max_catch_up_ticks)
+    {
+        on_tick(delta_time);
+
+        tick++;
+        ticks_run++;
+        next_tick_time += tick_duration;
+
+        if (tick % snapshot_interval == 0)
+        {
+            snapshot_due = true;
+        }
+
+        const auto tick_end = clock::now();
+        budget_usage = std::chrono::duration<float>(tick_end - now) / std::chrono::duration<float>(tick_duration);
+        stats.ticks++;
+        stats.total_budget_usage += budget_usage;
+        stats.max_budget_usage = std::max(stats.max_budget_usage, budget_usage);
+
+        now = tick_end;
+    }
+
+    // still behind after the catch-up cap, so skip the missed ticks instead of spiraling
+    if (now >= next_tick_time)
+    {
+        const auto missed_ticks = (now - next_tick_time) / tick_duration + 1;
+        stats.dropped_ticks += missed_ticks;
+        next_tick_time += missed_ticks * tick_duration;
+    }
+
+    // only the latest state matters, so catching up never sends more than one snapshot
+    // its cost is charged to the budget of the tick that produced it
+    if (snapshot_due)
+    {
+        on_snapshot();
+
+        const auto snapshot_budget_usage = std::chrono::duration<float>(clock::now() - now) / std::chrono::duration<float>(tick_duration);
+        stats.snapshots++;
+        stats.total_budget_usage += snapshot_budget_usage;
+        stats.max_budget_usage = std::max(stats.max_budget_usage, budget_usage + snapshot_budget_usage);
+    }
+}
+
+void ch::tick_scheduler::wait() const
+{
+    // waking a little late only shortens the next wait, since deadlines advance by whole ticks rather than from now
+    std::this_thread::sleep_until(next_tick_time);
+}
@@ -46,8 +46,7 @@ ch::world::world(
         std::size_t root_index = 0;
         for (const auto &conversation_json : conversations_json)
         {
-            std::size_t node_index = 0;
-            conversations.push_back({conversation_json, root_index++, &node_index});
+            conversations.push_back({conversation_json, root_index++});
         }
     }
 
@@ -0,0 +1,115 @@
+#include <ch/zone_link.hpp>
+
+#include <ch/deserializer.hpp>
+#include <ch/host.hpp>
+#include <ch/peer.hpp>
+#include <enet/enet.h>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+
+ch::zone_link::zone_link(
+    const char *const coordinator_hostname,
+    const std::uint16_t coordinator_port,
+    const std::uint16_t port,
+    const std::vector<std::size_t> &map_indices)
+{
+    host = std::make_unique<ch::host>(nullptr, 1, ch::channel_count, 0, 0);
+
+    ENetAddress address;
+    enet_address_set_host(&address, coordinator_hostname);
+    address.port = coordinator_port;
+    peer = std::make_unique<ch::peer>(host->get_enet_host(), &address, ch::channel_count, 0);
+
+    ENetEvent event;
+    while (host->service(&event, 3000) > 0)
+    {
+        if (event.type == ENET_EVENT_TYPE_CONNECT)
+        {
+            connected = true;
+            break;
+        }
+    }
+
+    if (!connected)
+    {
+        throw std::runtime_error("Failed to connect to coordinator");
+    }
+
+    spdlog::info("[Server] Connected to coordinator {}:{}", coordinator_hostname, coordinator_port);
+
+    ch::message_zone_register message;
+    message.type = ch::message_type::zone_register;
+    message.port = port;
+    message.map_indices = map_indices;
+    send(message);
+}
+
+ch::zone_link::~zone_link()
+{
+    if (!connected)
+    {
+        return;
+    }
+
+    peer->disconnect();
+
+    ENetEvent event;
+    while (host->service(&event, 1000) > 0)
+    {
+        if (event.type == ENET_EVENT_TYPE_RECEIVE)
+        {
+            enet_packet_destroy(event.packet);
+        }
+        else if (event.type == ENET_EVENT_TYPE_DISCONNECT)
+        {
+            peer->mark_successfully_disconnected();
+            break;
+        }
+    }
+}
+
+void ch::zone_link::send(const std::vector<std::uint8_t> &message, const ch::channel channel)
+{
+    peer->send(channel, ch::create_message_packet(packet_pool, message, channel));
+}
+
+void ch::zone_link::poll(const std::function<void(ch::deserializer &)> &on_message)
+{
+    ENetEvent event;
+    while (host->service(&event, 0) > 0)
+    {
+        switch (event.type)
+        {
+        case ENET_EVENT_TYPE_RECEIVE:
+        {
+            ch::deserializer packet_deserializer(event.packet->data, event.packet->dataLength);
+            while (!packet_deserializer.is_at_end())
+            {
+                auto deserializer = packet_deserializer.read_frame();
+                if (!packet_deserializer.is_valid())
+                {
+                    spdlog::warn("[Server] Malformed packet from coordinator");
+                    break;
+                }
+
+                on_message(deserializer);
+            }
+
+            enet_packet_destroy(event.packet);
+        }
+        break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+        {
+            spdlog::error("[Server] Lost connection to coordinator");
+
+            connected = false;
+            peer->mark_successfully_disconnected();
+        }
+        break;
+        default:
+        {
+        }
+        break;
+        }
+    }
+}
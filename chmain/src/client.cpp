@@ -1,29 +1,56 @@
 #include "client.hpp"
 
-#include "peer.hpp"
 #include <ch/conversation.hpp>
+#include <ch/deserializer.hpp>
 #include <ch/host.hpp>
+#include <ch/map.hpp>
 #include <ch/message.hpp>
+#include <ch/peer.hpp>
 #include <ch/world.hpp>
 #include <enet/enet.h>
+#include <algorithm>
+#include <cmath>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
 
+namespace
+{
+    void set_quest_status(std::vector<ch::quest_status> &quest_statuses, const ch::quest_status &status)
+    {
+        const auto quest_status = std::find_if(
+            quest_statuses.begin(),
+            quest_statuses.end(),
+            [status](const auto &quest_status)
+            {
+                return quest_status.quest_index == status.quest_index;
+            });
+
+        if (quest_status == quest_statuses.end())
+        {
+            quest_statuses.push_back(status);
+        }
+        else
+        {
+            quest_status->stage_index = status.stage_index;
+        }
+    }
+}
+
 ch::client::client(
     const char *const hostname,
     const std::uint16_t port,
-    const std::shared_ptr<ch::world> world)
-    : world(world)
+    const std::shared_ptr<ch::world> world,
+    const std::uint32_t token,
+    const std::uint64_t player_key)
+    : world(world),
+      player_key(player_key)
 {
-    players.fill(
-        {.id = ch::server::max_players});
-
-    host = std::make_unique<ch::host>(nullptr, 1, 2, 0, 0);
+    host = std::make_unique<ch::host>(nullptr, 1, ch::channel_count, 0, 0);
 
     ENetAddress address;
     enet_address_set_host(&address, hostname);
     address.port = port;
-    peer = std::make_unique<ch::peer>(host->get_enet_host(), &address, 2, 0);
+    peer = std::make_unique<ch::peer>(host->get_enet_host(), &address, ch::channel_count, token);
 
     bool connected = false;
     std::string failure_reason = "Host timeout";
@@ -37,17 +64,38 @@ ch::client::client(
         }
         else if (event.type == ENET_EVENT_TYPE_RECEIVE)
         {
-            const auto type = reinterpret_cast<ch::message *>(event.packet->data)->type;
+            ch::deserializer packet_deserializer(event.packet->data, event.packet->dataLength);
+            auto deserializer = packet_deserializer.read_frame();
+            const auto type = static_cast<ch::message_type>(deserializer.peek_u8());
 
             if (type == ch::message_type::server_joined)
             {
-                const auto message = reinterpret_cast<ch::message_id *>(event.packet->data);
+                ch::message_joined message;
+                message.read(deserializer);
 
-                spdlog::info("[Client] Successfully joined with ID {}", message->id);
+                if (deserializer.is_valid())
+                {
+                    spdlog::info("[Client] Successfully joined with ID {}", message.id);
+
+                    connected = true;
+                    self_id = message.id;
+                    resume_token = message.resume_token;
+                    players[self_id].id = self_id;
 
-                connected = true;
-                self_id = message->id;
-                players.at(self_id).id = self_id;
+                    // the rest of the join batch, the world state follows in its own packet
+                    while (packet_deserializer.is_valid() && !packet_deserializer.is_at_end())
+                    {
+                        auto frame_deserializer = packet_deserializer.read_frame();
+                        if (packet_deserializer.is_valid())
+                        {
+                            handle_message(frame_deserializer);
+                        }
+                    }
+                }
+                else
+                {
+                    failure_reason = "Malformed server response";
+                }
             }
             else if (type == ch::message_type::server_full)
             {
@@ -68,6 +116,12 @@ ch::client::client(
     {
         throw std::runtime_error(fmt::format("Failed to connect to server: {}", failure_reason).c_str());
     }
+
+    // lets the server restore progress saved in earlier sessions
+    ch::message_identify message;
+    message.type = ch::message_type::identify;
+    message.player_key = player_key;
+    send(message);
 }
 
 ch::client::~client()
@@ -101,99 +155,549 @@ void ch::client::handle_event(const SDL_Event &)
 {
 }
 
-void ch::client::update(const float)
+void ch::client::update(const float delta_time)
 {
+    // the newest input has been held for the whole frame
+    if (!pending_inputs.empty())
+    {
+        pending_inputs.back().duration += delta_time;
+    }
+
+    server_time += delta_time;
+
+    // a fixed rate keeps the packet rate from following the frame rate, and skipped samples would be identical anyway
+    constexpr auto input_interval = 1.0f / input_rate;
+    input_timer += delta_time;
+    if (input_timer >= input_interval)
+    {
+        input_timer = std::fmod(input_timer, input_interval);
+        sample_input();
+    }
+
+    const auto previous_map_index = players.at(self_id).map_index;
+    const auto previous_prediction = predict_self();
+    reconciled = false;
+
     ENetEvent event;
     while (host->service(&event, 0) > 0)
     {
         switch (event.type)
         {
-        case ENET_EVENT_TYPE_RECEIVE:
+        case ENET_EVENT_TYPE_CONNECT:
         {
-            const auto type = reinterpret_cast<ch::message *>(event.packet->data)->type;
-
-            switch (type)
+            if (pending_resume_token)
             {
-            case ch::message_type::player_connected:
+                ch::message_resume message;
+                message.type = ch::message_type::resume;
+                message.resume_token = pending_resume_token;
+                send(message);
+
+                pending_resume_token = 0;
+            }
+        }
+        break;
+        case ENET_EVENT_TYPE_RECEIVE:
+        {
+            ch::deserializer packet_deserializer(event.packet->data, event.packet->dataLength);
+            while (!packet_deserializer.is_at_end())
             {
-                const auto message = reinterpret_cast<ch::message_id *>(event.packet->data);
+                auto deserializer = packet_deserializer.read_frame();
+                if (!packet_deserializer.is_valid())
+                {
+                    spdlog::warn("[Client] Malformed packet");
+                    break;
+                }
+
+                handle_message(deserializer);
+            }
 
-                spdlog::info("[Client] Player {} connected", message->id);
+            enet_packet_destroy(event.packet);
+        }
+        break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+        {
+            peer->mark_successfully_disconnected();
 
-                players.at(message->id).id = message->id;
+            // a redirect is followed by the scene, anything else is a dropped connection worth one attempt at resuming
+            if (redirect || !resume_token)
+            {
+                spdlog::warn("[Client] Disconnected from server");
+                break;
             }
+
+            spdlog::warn("[Client] Connection lost, resuming session");
+
+            const auto address = peer->get_enet_peer()->address;
+            peer = std::make_unique<ch::peer>(host->get_enet_host(), &address, ch::channel_count, ch::peer::resuming);
+            pending_resume_token = resume_token;
+            resume_token = 0;
+        }
+        break;
+        default:
+        {
+        }
+        break;
+        }
+    }
+
+    interpolate_players();
+
+    auto &self = players.at(self_id);
+    const auto prediction = predict_self();
+
+    // blend corrections in over a few frames instead of snapping to them
+    if (reconciled)
+    {
+        if (self.map_index == previous_map_index)
+        {
+            prediction_error.x += previous_prediction.x - prediction.x;
+            prediction_error.y += previous_prediction.y - prediction.y;
+        }
+        else
+        {
+            prediction_error = {0, 0};
+        }
+    }
+
+    const auto decay = std::exp(-prediction_error_decay_rate * delta_time);
+    prediction_error.x *= decay;
+    prediction_error.y *= decay;
+
+    self.position_x = prediction.x + prediction_error.x;
+    self.position_y = prediction.y + prediction_error.y;
+}
+
+void ch::client::handle_message(ch::deserializer &deserializer)
+{
+    const auto type = static_cast<ch::message_type>(deserializer.peek_u8());
+
+    switch (type)
+    {
+    case ch::message_type::server_joined:
+    {
+        ch::message_joined message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
             break;
-            case ch::message_type::player_disconnected:
-            {
-                const auto message = reinterpret_cast<ch::message_id *>(event.packet->data);
+        }
 
-                spdlog::info("[Client] Player {} disconnected", message->id);
+        resume_token = message.resume_token;
 
-                players.at(message->id).id = ch::server::max_players;
-            }
+        // everything held here is still good, the server only sends what changed while away
+        if (message.resumed)
+        {
+            spdlog::info("[Client] Resumed session");
             break;
-            case ch::message_type::quest_status:
-            {
-                const auto message = reinterpret_cast<ch::message_quest_status *>(event.packet->data);
+        }
+
+        // the session expired, so this is a new player starting over
+        spdlog::info("[Client] Rejoined with ID {}", message.id);
+
+        players.clear();
+        quest_statuses.clear();
+        self_id = message.id;
+        players[self_id].id = self_id;
+        latest_sequence = 0;
+        snapshots = {};
+        interpolation_snapshots.clear();
+        pending_inputs.clear();
+        acked_input_sequence = 0;
+        prediction_error = {0, 0};
+
+        ch::message_identify identify_message;
+        identify_message.type = ch::message_type::identify;
+        identify_message.player_key = player_key;
+        send(identify_message);
+    }
+    break;
+    case ch::message_type::world_state:
+    {
+        ch::message_world_state message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        spdlog::info("[Client] {} players online", message.players.size());
 
-                spdlog::info("[Client] Player {} has advanced quest {} to state {}", message->id, message->status.quest_index, message->status.stage_index);
+        for (const auto &world_state_player : message.players)
+        {
+            quest_statuses[world_state_player.id] = world_state_player.quest_statuses;
 
-                players.at(message->id).set_quest_status(message->status);
+            const auto player = players.find(world_state_player.id);
+            if (player != players.end())
+            {
+                player->second.quest_statuses = world_state_player.quest_statuses;
             }
+        }
+    }
+    break;
+    case ch::message_type::player_connected:
+    {
+        ch::message_id message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
             break;
-            case ch::message_type::game_state:
-            {
-                const auto message = reinterpret_cast<ch::message_game_state *>(event.packet->data);
+        }
 
-                for (std::size_t i = 0; i < message->players.size(); i++)
-                {
-                    players.at(i).id = message->players.at(i).id;
+        // players appear once a snapshot puts them in view
+        spdlog::info("[Client] Player {} connected", message.id);
+    }
+    break;
+    case ch::message_type::player_disconnected:
+    {
+        ch::message_id message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
 
-                    players.at(i).map_index = message->players.at(i).map_index;
+        spdlog::info("[Client] Player {} disconnected", message.id);
 
-                    players.at(i).position_x = message->players.at(i).position_x;
-                    players.at(i).position_y = message->players.at(i).position_y;
+        quest_statuses.erase(message.id);
+        if (message.id != self_id)
+        {
+            players.erase(message.id);
+        }
+    }
+    break;
+    case ch::message_type::quest_status:
+    {
+        ch::message_quest_status message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
 
-                    players.at(i).direction = message->players.at(i).direction;
-                    players.at(i).animation = message->players.at(i).animation;
-                    players.at(i).frame_index = message->players.at(i).frame_index;
+        spdlog::info("[Client] Player {} has advanced quest {} to state {}", message.id, message.status.quest_index, message.status.stage_index);
 
-                    if (message->players.at(i).in_conversation)
-                    {
-                        players.at(i).conversation_root = &world->conversations.at(message->players.at(i).conversation_root_index);
-                        players.at(i).conversation_node = players.at(i).conversation_root->find_by_node_index(message->players.at(i).conversation_node_index);
-                    }
-                    else
-                    {
-                        players.at(i).conversation_root = nullptr;
-                        players.at(i).conversation_node = nullptr;
-                    }
-                }
-            }
+        set_quest_status(quest_statuses[message.id], message.status);
+
+        const auto player = players.find(message.id);
+        if (player != players.end())
+        {
+            player->second.set_quest_status(message.status);
+        }
+    }
+    break;
+    case ch::message_type::redirect:
+    {
+        ch::message_redirect message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
             break;
-            default:
-            {
-                spdlog::warn("[Client] Unknown message type {}", static_cast<int>(type));
-            }
+        }
+
+        spdlog::info("[Client] Redirected to zone on port {}", message.port);
+
+        redirect = message;
+    }
+    break;
+    case ch::message_type::conversation:
+    {
+        ch::message_conversation message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
             break;
-            }
+        }
 
-            enet_packet_destroy(event.packet);
+        auto &self = players.at(self_id);
+        if (message.in_conversation && message.root_index < world->conversations.size())
+        {
+            self.conversation_root = &world->conversations.at(message.root_index);
+            self.conversation_node = self.conversation_root->find_by_node_index(message.node_index);
         }
-        break;
+        else
+        {
+            self.conversation_root = nullptr;
+            self.conversation_node = nullptr;
+        }
+    }
+    break;
+    case ch::message_type::player_hit:
+    {
+        ch::message_hit message;
+        message.read(deserializer);
+        if (!deserializer.is_valid())
+        {
+            break;
+        }
+
+        spdlog::info("[Client] Player {} hit player {}", message.attacker_id, message.target_id);
+    }
+    break;
+    case ch::message_type::game_state:
+    {
+        ch::message_game_state message;
+        message.read(deserializer);
+        if (!deserializer.is_valid() || message.sequence <= latest_sequence)
+        {
+            break;
+        }
+
+        // the server only deltas against acked snapshots that are still in both histories
+        const ch::snapshot empty_snapshot;
+        const auto &baseline = message.baseline_sequence
+                                   ? snapshots.at(message.baseline_sequence % snapshots.size())
+                                   : empty_snapshot;
+        auto &snapshot = snapshots.at(message.sequence % snapshots.size());
+        if (!snapshot.read(baseline, message, *world, deserializer))
+        {
+            deserializer.invalidate();
+            break;
+        }
+
+        latest_sequence = snapshot.sequence;
+
+        {
+            ch::message_sequence ack_message;
+            ack_message.type = ch::message_type::game_state_ack;
+            ack_message.sequence = latest_sequence;
+            send(ack_message);
+        }
+
+        // the acked input may still be held, so keep it for the time the server hasn't simulated yet
+        acked_input_sequence = message.input_sequence;
+        while (!pending_inputs.empty() && pending_inputs.front().sequence < message.input_sequence)
+        {
+            pending_inputs.pop_front();
+        }
+        if (!pending_inputs.empty() && pending_inputs.front().sequence == message.input_sequence)
+        {
+            pending_inputs.front().acked_duration = static_cast<float>(message.input_ticks) / ch::server::tick_rate;
+        }
+
+        // nudge the server clock estimate towards the newest snapshot, but jump if it drifted too far
+        const auto snapshot_time = static_cast<double>(snapshot.tick) / ch::server::tick_rate;
+        if (interpolation_snapshots.empty() || std::abs(snapshot_time - server_time) > max_clock_drift)
+        {
+            server_time = snapshot_time;
+        }
+        else
+        {
+            server_time += (snapshot_time - server_time) * clock_correction_rate;
+        }
+
+        interpolation_snapshots.push_back(snapshot);
+        if (interpolation_snapshots.size() > interpolation_buffer_size)
+        {
+            interpolation_snapshots.pop_front();
+        }
+
+        const auto snapshot_self = snapshot.find(self_id);
+        if (!snapshot_self)
+        {
+            deserializer.invalidate();
+            break;
         }
+
+        apply_snapshot_player(players.at(self_id), *snapshot_self);
+
+        const auto &self = players.at(self_id);
+        server_position = {self.position_x, self.position_y};
+        reconciled = true;
+    }
+    break;
+    default:
+    {
+        spdlog::warn("[Client] Unknown message type {}", static_cast<int>(type));
+    }
+    break;
+    }
+
+    if (!deserializer.is_valid())
+    {
+        spdlog::warn("[Client] Malformed message of type {}", static_cast<int>(type));
     }
+}
 
-    // TODO: client side prediction?
+void ch::client::send(const std::vector<std::uint8_t> &buffer, const ch::channel channel)
+{
+    peer->send(channel, ch::create_message_packet(packet_pool, buffer, channel));
 }
 
-void ch::client::send(const void *const data, const std::size_t length, const std::uint32_t flags) const
+void ch::client::set_input(const std::int8_t input_x, const std::int8_t input_y)
 {
-    const auto packet = enet_packet_create(data, length, flags);
-    peer->send(packet);
+    this->input_x = input_x;
+    this->input_y = input_y;
+}
+
+void ch::client::sample_input()
+{
+    const auto changed = pending_inputs.empty() ||
+                         pending_inputs.back().input_x != input_x ||
+                         pending_inputs.back().input_y != input_y;
+
+    if (changed || ++input_ticks_since_sent >= input_keepalive_interval)
+    {
+        pending_inputs.push_back({++input_sequence, input_x, input_y, 0, 0});
+        if (pending_inputs.size() > max_pending_inputs)
+        {
+            pending_inputs.pop_front();
+        }
+
+        input_ticks_since_sent = 0;
+        input_resends = changed ? input_redundancy : 0;
+    }
+    else if (input_resends > 0)
+    {
+        // inputs are unreliable, so repeat a change a few times rather than waiting for the keepalive if it is lost
+        input_resends--;
+    }
+    else
+    {
+        return;
+    }
+
+    ch::message_input message;
+    message.type = ch::message_type::input;
+    message.sequence = pending_inputs.back().sequence;
+
+    // repeat the latest few the server hasn't acked, so one lost message doesn't lose an input
+    auto first = pending_inputs.end() - 1;
+    while (first != pending_inputs.begin() &&
+           pending_inputs.end() - first < static_cast<std::ptrdiff_t>(ch::message_input::max_inputs) &&
+           (first - 1)->sequence > acked_input_sequence)
+    {
+        first--;
+    }
+    for (auto input = first; input != pending_inputs.end(); input++)
+    {
+        message.inputs.push_back({input->input_x, input->input_y});
+    }
+
+    send(message);
 }
 
 const ch::player &ch::client::get_self() const
 {
     return players.at(self_id);
 }
+
+const std::optional<ch::message_redirect> &ch::client::get_redirect() const
+{
+    return redirect;
+}
+
+std::uint64_t ch::client::get_view_tick() const
+{
+    return static_cast<std::uint64_t>(std::max(server_time - interpolation_delay, 0.0) * ch::server::tick_rate + 0.5);
+}
+
+b2Vec2 ch::client::predict_self() const
+{
+    constexpr auto step_time = 1.0f / ch::server::tick_rate;
+
+    const auto &map = world->maps.at(players.at(self_id).map_index);
+
+    // replay the inputs the server hasn't processed yet on top of its latest position
+    auto position = server_position;
+    for (const auto &input : pending_inputs)
+    {
+        const auto velocity = ch::player::get_velocity(input.input_x, input.input_y);
+        if (velocity.x == 0 && velocity.y == 0)
+        {
+            continue;
+        }
+
+        for (auto remaining_time = input.duration - input.acked_duration; remaining_time > 0; remaining_time -= step_time)
+        {
+            const auto time = std::min(remaining_time, step_time);
+
+            if (!map.is_solid_at(position.x + velocity.x * time, position.y))
+            {
+                position.x += velocity.x * time;
+            }
+            if (!map.is_solid_at(position.x, position.y + velocity.y * time))
+            {
+                position.y += velocity.y * time;
+            }
+        }
+    }
+
+    return position;
+}
+
+void ch::client::apply_snapshot_player(ch::player &player, const ch::snapshot_player &snapshot_player) const
+{
+    player.id = snapshot_player.id;
+
+    player.map_index = snapshot_player.map_index;
+
+    player.position_x = snapshot_player.position_x;
+    player.position_y = snapshot_player.position_y;
+
+    player.direction = snapshot_player.direction;
+    player.animation = snapshot_player.animation;
+    player.frame_index = snapshot_player.frame_index;
+}
+
+void ch::client::interpolate_players()
+{
+    if (interpolation_snapshots.empty())
+    {
+        return;
+    }
+
+    // render everyone else slightly in the past so there is usually a snapshot on either side
+    const auto render_time = server_time - interpolation_delay;
+    const auto get_snapshot_time = [](const ch::snapshot &snapshot)
+    {
+        return static_cast<double>(snapshot.tick) / ch::server::tick_rate;
+    };
+
+    std::size_t from_index = 0;
+    while (from_index + 1 < interpolation_snapshots.size() && get_snapshot_time(interpolation_snapshots.at(from_index + 1)) <= render_time)
+    {
+        from_index++;
+    }
+
+    const auto &from = interpolation_snapshots.at(from_index);
+    const auto &to = interpolation_snapshots.at(std::min(from_index + 1, interpolation_snapshots.size() - 1));
+    const auto from_time = get_snapshot_time(from);
+    const auto to_time = get_snapshot_time(to);
+    const auto alpha = to_time > from_time
+                           ? static_cast<float>(std::clamp((render_time - from_time) / (to_time - from_time), 0.0, 1.0))
+                           : 0.0f;
+
+    std::erase_if(
+        players,
+        [this, &from](const auto &entry)
+        {
+            return entry.first != self_id && !from.find(entry.first);
+        });
+
+    for (const auto &from_player : from.players)
+    {
+        if (from_player.id == self_id)
+        {
+            continue;
+        }
+
+        const auto [entry, inserted] = players.try_emplace(from_player.id);
+        auto &player = entry->second;
+        if (inserted)
+        {
+            const auto player_quest_statuses = quest_statuses.find(from_player.id);
+            if (player_quest_statuses != quest_statuses.end())
+            {
+                player.quest_statuses = player_quest_statuses->second;
+            }
+        }
+        apply_snapshot_player(player, from_player);
+
+        const auto to_player = to.find(from_player.id);
+        if (to_player && to_player->map_index == from_player.map_index)
+        {
+            player.position_x = std::lerp(from_player.position_x, to_player->position_x, alpha);
+            player.position_y = std::lerp(from_player.position_y, to_player->position_y, alpha);
+        }
+    }
+}
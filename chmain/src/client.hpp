@@ -2,8 +2,16 @@
 #define CH_CLIENT_HPP
 
 #include <SDL2/SDL.h>
+#include <ch/channel.hpp>
+#include <ch/message.hpp>
+#include <ch/packet_pool.hpp>
 #include <ch/server.hpp>
+#include <ch/snapshot.hpp>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 struct _ENetPacket;
 typedef _ENetPacket ENetPacket;
@@ -16,12 +24,15 @@ namespace ch
     class client
     {
     public:
-        std::array<ch::player, ch::server::max_players> players;
+        // players in view, keyed by id
+        std::unordered_map<std::size_t, ch::player> players;
 
         client(
             const char *hostname,
             std::uint16_t port,
-            std::shared_ptr<ch::world> world);
+            std::shared_ptr<ch::world> world,
+            std::uint32_t token,
+            std::uint64_t player_key);
         ~client();
         client(const client &other) = delete;
         client &operator=(const client &other) = delete;
@@ -31,15 +42,77 @@ namespace ch
         void handle_event(const SDL_Event &event);
         void update(float delta_time);
 
-        void send(const void *data, std::size_t length, std::uint32_t flags) const;
+        template <typename T>
+        void send(const T &message)
+        {
+            send(ch::serialize(message), ch::get_channel(message.type));
+        }
+
+        void send(const std::vector<std::uint8_t> &buffer, ch::channel channel);
+        // sampled at input_rate, and only sent when it changes or as a keepalive
+        void set_input(std::int8_t input_x, std::int8_t input_y);
 
         const ch::player &get_self() const;
+        // the server tick other players are currently rendered at
+        std::uint64_t get_view_tick() const;
+        // set once the server hands this player off to another zone, which should be joined with the token
+        const std::optional<ch::message_redirect> &get_redirect() const;
 
     private:
+        struct pending_input
+        {
+            std::uint32_t sequence;
+            std::int8_t input_x;
+            std::int8_t input_y;
+            float duration;
+            float acked_duration; // already simulated by the server
+        };
+
+        static constexpr std::uint32_t input_rate = 30;
+        static constexpr std::uint32_t input_keepalive_interval = input_rate / 4; // in input ticks
+        static constexpr std::uint32_t input_redundancy = 2;                      // extra sends of each change
+        static constexpr std::size_t max_pending_inputs = 256;
+        static constexpr float prediction_error_decay_rate = 15.0f;
+        static constexpr std::size_t interpolation_buffer_size = 8;
+        static constexpr double interpolation_delay = static_cast<double>(ch::server::interpolation_delay_ticks) / ch::server::tick_rate;
+        static constexpr double max_clock_drift = 0.25;
+        static constexpr double clock_correction_rate = 0.1;
+
         std::shared_ptr<ch::world> world;
+        ch::packet_pool packet_pool;
         std::unique_ptr<ch::host> host;
         std::unique_ptr<ch::peer> peer;
+        std::uint64_t player_key;
+        std::uint64_t resume_token = 0;
+        std::uint64_t pending_resume_token = 0; // presented once the new connection is up
         std::size_t self_id;
+        std::uint32_t latest_sequence = 0;
+        std::array<ch::snapshot, ch::server::snapshot_history_size> snapshots;
+
+        std::int8_t input_x = 0;
+        std::int8_t input_y = 0;
+        float input_timer = 0;
+        std::uint32_t input_ticks_since_sent = 0;
+        std::uint32_t input_resends = 0;
+        std::uint32_t input_sequence = 0;
+        std::uint32_t acked_input_sequence = 0;
+        std::deque<pending_input> pending_inputs;
+        b2Vec2 server_position = {0, 0};
+        b2Vec2 prediction_error = {0, 0};
+        bool reconciled = false;
+        std::optional<ch::message_redirect> redirect;
+
+        double server_time = 0;
+        std::deque<ch::snapshot> interpolation_snapshots;
+
+        // every online player's quests, including those out of view, applied when they come into view
+        std::unordered_map<std::size_t, std::vector<ch::quest_status>> quest_statuses;
+
+        void handle_message(ch::deserializer &deserializer);
+        void sample_input();
+        void apply_snapshot_player(ch::player &player, const ch::snapshot_player &snapshot_player) const;
+        void interpolate_players();
+        b2Vec2 predict_self() const;
     };
 }
 
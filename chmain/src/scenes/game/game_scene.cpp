@@ -16,17 +16,48 @@
 #include <ch/map.hpp>
 #include <ch/message.hpp>
 #include <ch/server.hpp>
+#include <ch/tick_scheduler.hpp>
 #include <ch/tileset.hpp>
 #include <ch/world.hpp>
 #include <exception>
+#include <fstream>
+#include <random>
 #include <spdlog/spdlog.h>
 
+namespace
+{
+    // identifies this install to servers that save progress, made up the first time the game runs
+    std::uint64_t load_player_key()
+    {
+        constexpr const char *player_key_filename = "player.key";
+
+        std::uint64_t player_key = 0;
+        if (std::ifstream file(player_key_filename); file >> player_key && player_key)
+        {
+            return player_key;
+        }
+
+        std::random_device random_device;
+        std::uniform_int_distribution<std::uint64_t> key_distribution(1);
+        player_key = key_distribution(random_device);
+
+        if (!(std::ofstream(player_key_filename) << player_key))
+        {
+            spdlog::warn("[Client] Failed to save player key, progress will not carry over to the next session");
+        }
+
+        return player_key;
+    }
+}
+
 ch::game_scene::game_scene(
     std::shared_ptr<ch::display> display,
     const char *const hostname,
     const std::uint16_t port,
     const bool is_host)
-    : ch::scene(display)
+    : ch::scene(display),
+      hostname(hostname),
+      player_key(load_player_key())
 {
     const auto renderer = display->get_renderer();
 
@@ -42,14 +73,18 @@ ch::game_scene::game_scene(
 
     if (is_host)
     {
-        server = std::make_unique<ch::server>(port, world);
+        server = std::make_unique<ch::server>(port, world, ch::server::default_max_players, ch::server::default_view_radius);
+        server_scheduler = std::make_unique<ch::tick_scheduler>(
+            ch::server::tick_rate,
+            ch::server::snapshot_rate,
+            ch::server::max_catch_up_ticks);
     }
 
     display->clear();
     font->render(0, 0, 0, {255, 255, 255}, "Connecting to server...");
     display->present();
 
-    client = std::make_unique<ch::client>(hostname, port, world);
+    client = std::make_unique<ch::client>(hostname, port, world, 0, player_key);
 
     std::transform(
         world->items.begin(),
@@ -59,8 +94,6 @@ ch::game_scene::game_scene(
         {
             return std::make_unique<ch::loaded_item>(item, renderer);
         });
-
-    weapon_item_index = 0;
 }
 
 ch::scene *ch::game_scene::handle_event(const SDL_Event &event)
@@ -79,7 +112,7 @@ ch::scene *ch::game_scene::handle_event(const SDL_Event &event)
 
             ch::message message;
             message.type = ch::message_type::end_conversation;
-            client->send(&message, sizeof(message), 0);
+            client->send(message);
         }
         break;
         case SDLK_SPACE:
@@ -88,15 +121,16 @@ ch::scene *ch::game_scene::handle_event(const SDL_Event &event)
             {
                 ch::message message;
                 message.type = ch::message_type::advance_conversation;
-                client->send(&message, sizeof(message), 0);
+                client->send(message);
             }
             else
             {
-                ch::message message;
+                ch::message_attack message;
                 message.type = ch::message_type::attack;
-                client->send(&message, sizeof(message), 0);
+                message.view_tick = client->get_view_tick();
+                client->send(message);
 
-                const auto &loaded_weapon = loaded_items.at(weapon_item_index);
+                const auto &loaded_weapon = loaded_items.at(ch::player::weapon_item_index);
                 loaded_weapon->attack_sound->play();
             }
         }
@@ -116,7 +150,7 @@ ch::scene *ch::game_scene::handle_event(const SDL_Event &event)
                 ch::message_id message;
                 message.type = ch::message_type::choose_conversation_response;
                 message.id = event.key.keysym.sym - 48;
-                client->send(&message, sizeof(message), 0);
+                client->send(message);
             }
         }
         break;
@@ -135,7 +169,7 @@ ch::scene *ch::game_scene::handle_event(const SDL_Event &event)
             ch::message_id message;
             message.type = ch::message_type::change_map;
             message.id = 0;
-            client->send(&message, sizeof(message), 0);
+            client->send(message);
         }
         break;
         case SDLK_F2:
@@ -143,7 +177,7 @@ ch::scene *ch::game_scene::handle_event(const SDL_Event &event)
             ch::message_id message;
             message.type = ch::message_type::change_map;
             message.id = 1;
-            client->send(&message, sizeof(message), 0);
+            client->send(message);
         }
         break;
         case SDLK_F3:
@@ -151,7 +185,7 @@ ch::scene *ch::game_scene::handle_event(const SDL_Event &event)
             ch::message_id message;
             message.type = ch::message_type::start_conversation;
             message.id = 0;
-            client->send(&message, sizeof(message), 0);
+            client->send(message);
         }
         break;
         case SDLK_F4:
@@ -159,7 +193,7 @@ ch::scene *ch::game_scene::handle_event(const SDL_Event &event)
             ch::message_id message;
             message.type = ch::message_type::start_conversation;
             message.id = 1;
-            client->send(&message, sizeof(message), 0);
+            client->send(message);
         }
         break;
         case SDLK_F5:
@@ -167,7 +201,7 @@ ch::scene *ch::game_scene::handle_event(const SDL_Event &event)
             ch::message_quest_status message;
             message.type = ch::message_type::quest_status;
             message.status = {0, 1};
-            client->send(&message, sizeof(message), 0);
+            client->send(message);
         }
         break;
         case SDLK_F6:
@@ -175,7 +209,7 @@ ch::scene *ch::game_scene::handle_event(const SDL_Event &event)
             ch::message_quest_status message;
             message.type = ch::message_type::quest_status;
             message.status = {0, 3};
-            client->send(&message, sizeof(message), 0);
+            client->send(message);
         }
         break;
         case SDLK_F10:
@@ -214,39 +248,52 @@ ch::scene *ch::game_scene::update(
         active_map = std::make_unique<ch::active_map>(world->maps.at(map_index), renderer);
     }
 
+    if (server)
+    {
+        server_scheduler->update(
+            [this](const float server_delta_time)
+            {
+                server->update(server_delta_time);
+            },
+            [this]()
+            {
+                server->send_game_state();
+            });
+    }
+
+    client->update(delta_time);
+
+    // zones share the host, so only the port changes
+    if (const auto redirect = client->get_redirect())
+    {
+        client.reset();
+        client = std::make_unique<ch::client>(hostname.c_str(), redirect->port, world, redirect->token, player_key);
+    }
+
     {
-        ch::message_input message;
-        message.type = ch::message_type::input;
-        message.input_x = 0;
-        message.input_y = 0;
+        input_x = 0;
+        input_y = 0;
 
         if (keys[SDL_SCANCODE_W])
         {
-            message.input_y = -1;
+            input_y = -1;
         }
         if (keys[SDL_SCANCODE_A])
         {
-            message.input_x = -1;
+            input_x = -1;
         }
         if (keys[SDL_SCANCODE_S])
         {
-            message.input_y = 1;
+            input_y = 1;
         }
         if (keys[SDL_SCANCODE_D])
         {
-            message.input_x = 1;
+            input_x = 1;
         }
 
-        client->send(&message, sizeof(message), 0);
-    }
-
-    if (server)
-    {
-        server->update(delta_time);
+        client->set_input(input_x, input_y);
     }
 
-    client->update(delta_time);
-
     const auto &map = world->maps.at(map_index);
 
     constexpr std::size_t sprite_scale = 2;
@@ -371,9 +418,9 @@ ch::scene *ch::game_scene::update(
         }
     }
 
-    for (const auto &player : client->players)
+    for (const auto &[id, player] : client->players)
     {
-        if (player.id != ch::server::max_players && player.map_index == map_index)
+        if (player.map_index == map_index)
         {
             constexpr int player_sprite_size = 16;
             const int player_x = static_cast<int>((player.position_x - view_x) * sprite_scale);
@@ -422,8 +469,8 @@ ch::scene *ch::game_scene::update(
 
             if (player.animation == ch::animation::attacking)
             {
-                const auto &weapon = world->items.at(weapon_item_index);
-                const auto &loaded_weapon = loaded_items.at(weapon_item_index);
+                const auto &weapon = world->items.at(ch::player::weapon_item_index);
+                const auto &loaded_weapon = loaded_items.at(ch::player::weapon_item_index);
                 const auto &attack_position = weapon.attack_positions.at(static_cast<std::size_t>(player.direction));
 
                 ch::renderable weapon_renderable;
@@ -462,9 +509,9 @@ ch::scene *ch::game_scene::update(
             SDL_FLIP_NONE);
     }
 
-    for (const auto &player : client->players)
+    for (const auto &[id, player] : client->players)
     {
-        if (player.id != ch::server::max_players && player.map_index == map_index)
+        if (player.map_index == map_index)
         {
             const int player_x = static_cast<int>((player.position_x - view_x) * sprite_scale);
             const int player_y = static_cast<int>((player.position_y - view_y) * sprite_scale);
@@ -520,9 +567,10 @@ ch::scene *ch::game_scene::update(
         dialog_box->render(nullptr, &dstrect);
         font->render(x + 18, y + 36, w, {0, 0, 0}, "{}", self.conversation_node->text);
 
-        for (std::size_t i = 0; i < self.conversation_node->children.size(); i++)
+        const auto children = self.conversation_root->get_children(*self.conversation_node);
+        for (std::size_t i = 0; i < children.size(); i++)
         {
-            const auto &child = self.conversation_node->children.at(i);
+            const auto &child = children[i];
             if (child.type == ch::conversation_type::response && child.check_conditions(self))
             {
                 font->render(x + 18, y + 36 + (18 * (i + 1)), w, {0, 0, 0}, "{}) {}", i + 1, child.text);
@@ -5,6 +5,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace ch
@@ -16,6 +17,7 @@ namespace ch
     class server;
     class sound;
     class texture;
+    class tick_scheduler;
     class world;
 
     class game_scene : public ch::scene
@@ -37,13 +39,15 @@ namespace ch
 
     private:
         std::unique_ptr<ch::font> font;
+        std::string hostname;
+        std::uint64_t player_key;
         std::shared_ptr<ch::world> world;
         std::unique_ptr<ch::server> server;
+        std::unique_ptr<ch::tick_scheduler> server_scheduler;
         std::unique_ptr<ch::client> client;
         std::unique_ptr<ch::active_map> active_map;
         std::vector<std::unique_ptr<ch::loaded_item>> loaded_items;
         std::size_t map_index;
-        std::size_t weapon_item_index;
         std::unique_ptr<ch::texture> player_spritesheet;
         std::unique_ptr<ch::texture> dialog_box;
         bool quest_log_open = false;
@@ -1,17 +1,268 @@
 #include <SDL2/SDL.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <ch/command_log.hpp>
+#include <ch/coordinator.hpp>
 #include <ch/enet.hpp>
 #include <ch/sdl.hpp>
 #include <ch/server.hpp>
+#include <ch/tick_scheduler.hpp>
 #include <ch/world.hpp>
 #include <memory>
 #include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <vector>
 
 constexpr std::uint16_t server_port = 8492;
+constexpr const char *coordinator_hostname = "127.0.0.1";
+constexpr std::uint32_t coordinator_poll_timeout = 100;
+constexpr std::uint64_t server_stats_interval_ticks = ch::server::tick_rate * 10;
+constexpr std::size_t logged_peer_count = 5;
 
-int main(int, char *[])
+namespace
 {
-    const ch::sdl sdl(SDL_INIT_EVENTS);
-    const ch::enet enet;
+    void log_network_stats(const ch::network_stats &stats)
+    {
+        spdlog::info("[Server] Sent {} packets, {} bytes", stats.packets_sent, stats.bytes_sent);
+
+        for (std::size_t i = 0; i < stats.message_types.size(); i++)
+        {
+            const auto &message_stats = stats.message_types.at(i);
+            if (message_stats.messages_sent)
+            {
+                spdlog::info("[Server] Message type {}: {} sent, {} bytes", i, message_stats.messages_sent, message_stats.bytes_sent);
+            }
+        }
+
+        // only the slowest peers, a full server would flood the log
+        std::vector<std::size_t> peer_ids;
+        for (std::size_t i = 0; i < stats.peers.size(); i++)
+        {
+            if (stats.peers.at(i).samples)
+            {
+                peer_ids.push_back(i);
+            }
+        }
+        const auto logged_peers = std::min(peer_ids.size(), logged_peer_count);
+        std::partial_sort(
+            peer_ids.begin(),
+            peer_ids.begin() + logged_peers,
+            peer_ids.end(),
+            [&stats](const std::size_t a, const std::size_t b)
+            {
+                return stats.peers.at(a).average_round_trip_time() > stats.peers.at(b).average_round_trip_time();
+            });
+
+        for (std::size_t i = 0; i < logged_peers; i++)
+        {
+            const auto &peer_stats = stats.peers.at(peer_ids.at(i));
+
+            spdlog::info(
+                "[Server] Peer {}: rtt {:.0f}ms avg {}ms max, loss {:.1f}% max, throttle {:.0f}% min, queue {} max, sent {} packets {} bytes, {} snapshots sent {} skipped",
+                peer_ids.at(i),
+                peer_stats.average_round_trip_time(),
+                peer_stats.max_round_trip_time,
+                peer_stats.max_packet_loss * 100,
+                peer_stats.min_packet_throttle * 100,
+                peer_stats.max_outgoing_queue_size,
+                peer_stats.packets_sent,
+                peer_stats.bytes_sent,
+                peer_stats.snapshots_sent,
+                peer_stats.snapshots_skipped);
+        }
+    }
+
+    // the whole text as a number, rejecting anything else
+    template <typename T>
+    bool parse_number(const std::string_view text, T &value)
+    {
+        const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    bool parse_map_indices(const std::string_view list, std::vector<std::size_t> &map_indices)
+    {
+        map_indices.clear();
+
+        std::size_t start = 0;
+        while (start <= list.size())
+        {
+            const auto end = std::min(list.find(',', start), list.size());
+
+            std::size_t map_index;
+            if (!parse_number(list.substr(start, end - start), map_index))
+            {
+                return false;
+            }
+            map_indices.push_back(map_index);
+
+            start = end + 1;
+        }
+
+        return true;
+    }
+
+    // only relays handoffs between zones, there is no world to simulate
+    int coordinate(const std::uint16_t port)
+    {
+        const ch::sdl sdl(SDL_INIT_EVENTS);
+        const ch::enet enet;
+
+        ch::coordinator coordinator(port);
+
+        bool running = true;
+        while (running)
+        {
+            SDL_Event event;
+            while (sdl.poll_event(event))
+            {
+                if (event.type == SDL_QUIT)
+                {
+                    running = false;
+                }
+            }
+
+            coordinator.update(coordinator_poll_timeout);
+        }
+
+        return 0;
+    }
+
+    // feeds a recorded session through the tick loop as fast as possible, without ENet or waiting
+    int replay(const std::shared_ptr<ch::world> world, const std::size_t max_players, const std::string &filename)
+    {
+        using clock = std::chrono::steady_clock;
+
+        ch::command_log_reader command_log(filename);
+        ch::server server(world, max_players, ch::server::default_view_radius);
+
+        // per-command logging would dominate the measurement
+        spdlog::set_level(spdlog::level::warn);
+
+        std::uint64_t commands = 0;
+        std::uint64_t snapshots = 0;
+        clock::duration update_time = {};
+        clock::duration snapshot_time = {};
+
+        const auto start = clock::now();
+
+        ch::command_log_entry entry;
+        while (command_log.read(entry))
+        {
+            while (server.get_tick() < entry.tick)
+            {
+                const auto update_start = clock::now();
+                server.update(1.0f / ch::server::tick_rate);
+                update_time += clock::now() - update_start;
+            }
+
+            if (entry.snapshot)
+            {
+                const auto snapshot_start = clock::now();
+                server.send_game_state();
+                snapshot_time += clock::now() - snapshot_start;
+
+                snapshots++;
+            }
+            else
+            {
+                server.replay_command(entry.command);
+
+                commands++;
+            }
+        }
+
+        const auto total_time = std::chrono::duration<double>(clock::now() - start).count();
+        const auto to_milliseconds = [](const clock::duration duration)
+        {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        };
+        const auto ticks = server.get_tick();
+
+        spdlog::set_level(spdlog::level::info);
+        spdlog::info(
+            "[Server] Replayed {} ticks, {} commands, {} snapshots in {:.3f}s ({:.0f} ticks/s)",
+            ticks,
+            commands,
+            snapshots,
+            total_time,
+            total_time > 0 ? ticks / total_time : 0);
+        spdlog::info(
+            "[Server] update {:.3f}ms/tick, simulation {:.3f}ms/tick, snapshot {:.3f}ms/snapshot",
+            ticks ? to_milliseconds(update_time) / ticks : 0,
+            ticks ? to_milliseconds(server.get_simulation_time()) / ticks : 0,
+            snapshots ? to_milliseconds(snapshot_time) / snapshots : 0);
+
+        return 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::uint16_t port = server_port;
+    std::size_t max_players = ch::server::default_max_players;
+    std::string record_filename;
+    std::string replay_filename;
+    std::string progress_filename;
+    std::vector<std::size_t> map_indices;
+    std::uint16_t zone_coordinator_port = 0;
+    std::uint16_t coordinator_port = 0;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string option = argv[i];
+        const std::string_view value = argv[i + 1];
+
+        bool valid = true;
+        if (option == "--port")
+        {
+            valid = parse_number(value, port) && port;
+        }
+        else if (option == "--max-players")
+        {
+            valid = parse_number(value, max_players) && max_players;
+        }
+        else if (option == "--record")
+        {
+            record_filename = value;
+        }
+        else if (option == "--replay")
+        {
+            replay_filename = value;
+        }
+        else if (option == "--progress")
+        {
+            progress_filename = value;
+        }
+        else if (option == "--maps")
+        {
+            valid = parse_map_indices(value, map_indices);
+        }
+        else if (option == "--zone")
+        {
+            valid = parse_number(value, zone_coordinator_port) && zone_coordinator_port;
+        }
+        else if (option == "--coordinator")
+        {
+            valid = parse_number(value, coordinator_port) && coordinator_port;
+        }
+        else
+        {
+            spdlog::warn("[Server] Unknown option {}", option);
+        }
+
+        if (!valid)
+        {
+            spdlog::error("[Server] Invalid value {} for {}", value, option);
+            return 1;
+        }
+    }
+
+    if (coordinator_port)
+    {
+        return coordinate(coordinator_port);
+    }
 
     const auto world = std::make_shared<ch::world>(
         "data/world.world",
@@ -19,16 +270,54 @@ int main(int, char *[])
         "data/conversations.json",
         "data/items.json");
 
-    ch::server server(server_port, world);
+    if (!replay_filename.empty())
+    {
+        return replay(world, max_players, replay_filename);
+    }
+
+    const ch::sdl sdl(SDL_INIT_EVENTS);
+    const ch::enet enet;
+
+    ch::server server(port, world, max_players, ch::server::default_view_radius);
+    if (zone_coordinator_port)
+    {
+        if (map_indices.empty())
+        {
+            spdlog::error("[Server] --zone needs --maps");
+            return 1;
+        }
+
+        // handoffs arrive from the coordinator rather than as commands, so a replay couldn't rebuild them
+        if (!record_filename.empty())
+        {
+            spdlog::error("[Server] --record can't be used with --zone");
+            return 1;
+        }
+
+        server.start_zone(map_indices, coordinator_hostname, zone_coordinator_port);
+    }
+    else if (!map_indices.empty())
+    {
+        spdlog::error("[Server] --maps needs --zone");
+        return 1;
+    }
+    if (!progress_filename.empty())
+    {
+        server.start_persistence(progress_filename);
+    }
+    if (!record_filename.empty())
+    {
+        server.start_recording(record_filename);
+    }
+
+    ch::tick_scheduler scheduler(
+        ch::server::tick_rate,
+        ch::server::snapshot_rate,
+        ch::server::max_catch_up_ticks);
 
-    std::uint64_t current_time = 0;
     bool running = true;
     while (running)
     {
-        const auto previous_time = current_time;
-        current_time = sdl.get_ticks();
-        const auto delta_time = (current_time - previous_time) / 1000.0f;
-
         SDL_Event event;
         while (sdl.poll_event(event))
         {
@@ -44,7 +333,40 @@ int main(int, char *[])
             server.handle_event(event);
         }
 
-        server.update(delta_time);
+        scheduler.update(
+            [&server](const float delta_time)
+            {
+                server.update(delta_time);
+            },
+            [&server]()
+            {
+                server.send_game_state();
+            });
+
+        if (scheduler.get_stats().ticks >= server_stats_interval_ticks)
+        {
+            const auto stats = scheduler.reset_stats();
+
+            spdlog::info(
+                "[Server] {} ticks, {} snapshots, {} dropped, budget usage {:.1f}% avg {:.1f}% max",
+                stats.ticks,
+                stats.snapshots,
+                stats.dropped_ticks,
+                stats.average_budget_usage() * 100,
+                stats.max_budget_usage * 100);
+
+            log_network_stats(server.reset_network_stats());
+
+            const auto allocation_stats = ch::enet::get_allocation_stats();
+            spdlog::info(
+                "[Server] ENet allocations {}, frees {}, {} pooled, {} from the system",
+                allocation_stats.allocations,
+                allocation_stats.frees,
+                allocation_stats.pooled_allocations,
+                allocation_stats.system_allocations);
+        }
+
+        scheduler.wait();
     }
 
     return 0;
@@ -0,0 +1,29 @@
+#ifndef CH_CHECK_HPP
+#define CH_CHECK_HPP
+
+#include <spdlog/spdlog.h>
+
+// failures are counted rather than thrown, so one run reports every broken check
+#define CH_CHECK(condition) ch::check((condition), #condition, __FILE__, __LINE__)
+
+namespace ch
+{
+    inline int check_failures = 0;
+
+    inline void check(const bool condition, const char *const expression, const char *const file, const int line)
+    {
+        if (!condition)
+        {
+            spdlog::error("[Test] {}:{}: check failed: {}", file, line, expression);
+
+            check_failures++;
+        }
+    }
+
+    inline int check_result()
+    {
+        return check_failures ? 1 : 0;
+    }
+}
+
+#endif
@@ -0,0 +1,161 @@
+#include "check.hpp"
+#include <ch/command_log.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::vector<ch::command_log_entry> make_entries()
+    {
+        std::vector<ch::command_log_entry> entries;
+
+        ch::command connect_command;
+        connect_command.type = ch::command_type::connect;
+        connect_command.peer_id = 3;
+        connect_command.id = 0;
+        connect_command.new_token = 0x0123456789abcdef;
+        connect_command.address = 0x0100007f;
+        entries.push_back({1, false, connect_command});
+
+        ch::command input_command;
+        input_command.type = ch::command_type::input;
+        input_command.peer_id = 3;
+        input_command.id = 17;
+        input_command.input_x = -1;
+        input_command.input_y = 1;
+        entries.push_back({1, false, input_command});
+
+        entries.push_back({1, true, {}});
+
+        ch::command attack_command;
+        attack_command.type = ch::command_type::attack;
+        attack_command.peer_id = 3;
+        attack_command.id = 200;
+        attack_command.round_trip_time = 85;
+        entries.push_back({300, false, attack_command});
+
+        ch::command quest_command;
+        quest_command.type = ch::command_type::quest_status;
+        quest_command.peer_id = 3;
+        quest_command.status = {2, 5};
+        entries.push_back({301, false, quest_command});
+
+        ch::command disconnect_command;
+        disconnect_command.type = ch::command_type::disconnect;
+        disconnect_command.peer_id = 3;
+        entries.push_back({100000, false, disconnect_command});
+
+        return entries;
+    }
+
+    bool same_entry(const ch::command_log_entry &a, const ch::command_log_entry &b)
+    {
+        if (a.tick != b.tick || a.snapshot != b.snapshot)
+        {
+            return false;
+        }
+        if (a.snapshot)
+        {
+            return true;
+        }
+
+        return a.command.type == b.command.type &&
+               a.command.peer_id == b.command.peer_id &&
+               a.command.id == b.command.id &&
+               a.command.input_x == b.command.input_x &&
+               a.command.input_y == b.command.input_y &&
+               a.command.status.quest_index == b.command.status.quest_index &&
+               a.command.status.stage_index == b.command.status.stage_index &&
+               a.command.token == b.command.token &&
+               a.command.new_token == b.command.new_token &&
+               a.command.address == b.command.address &&
+               a.command.round_trip_time == b.command.round_trip_time;
+    }
+
+    void test_round_trip(const std::string &filename)
+    {
+        const auto entries = make_entries();
+
+        {
+            ch::command_log_writer writer(filename);
+            for (std::size_t i = 0; i < entries.size(); i++)
+            {
+                writer.write(entries.at(i));
+
+                // flushing part way through mustn't lose or reorder anything
+                if (i == entries.size() / 2)
+                {
+                    writer.flush();
+                }
+            }
+        }
+
+        ch::command_log_reader reader(filename);
+        ch::command_log_entry entry;
+        for (const auto &expected : entries)
+        {
+            CH_CHECK(reader.read(entry));
+            CH_CHECK(same_entry(entry, expected));
+        }
+        CH_CHECK(!reader.read(entry));
+    }
+
+    void test_truncated(const std::string &filename)
+    {
+        {
+            ch::command_log_writer writer(filename);
+            for (const auto &entry : make_entries())
+            {
+                writer.write(entry);
+            }
+        }
+
+        std::filesystem::resize_file(filename, std::filesystem::file_size(filename) - 1);
+
+        // everything before the cut still replays, then reading stops
+        ch::command_log_reader reader(filename);
+        ch::command_log_entry entry;
+        std::size_t count = 0;
+        while (reader.read(entry))
+        {
+            count++;
+        }
+        CH_CHECK(count == make_entries().size() - 1);
+    }
+
+    void test_invalid_header(const std::string &filename)
+    {
+        {
+            std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+            file << "NOPE";
+        }
+
+        auto threw = false;
+        try
+        {
+            ch::command_log_reader reader(filename);
+        }
+        catch (const std::runtime_error &)
+        {
+            threw = true;
+        }
+        CH_CHECK(threw);
+    }
+}
+
+int main()
+{
+    const auto filename = (std::filesystem::temp_directory_path() / "chtest_command_log.chcl").string();
+
+    test_round_trip(filename);
+    test_truncated(filename);
+    test_invalid_header(filename);
+
+    std::filesystem::remove(filename);
+
+    return ch::check_result();
+}
@@ -0,0 +1,149 @@
+#include "check.hpp"
+#include <ch/deserializer.hpp>
+#include <ch/message.hpp>
+#include <ch/serializer.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    void test_read_past_end()
+    {
+        const std::uint8_t data[] = {5};
+
+        ch::deserializer deserializer(data, sizeof(data));
+        CH_CHECK(deserializer.read_u8() == 5);
+        CH_CHECK(deserializer.is_valid());
+
+        // reads past the end come back as zero and poison the rest of the message
+        CH_CHECK(deserializer.read_u8() == 0);
+        CH_CHECK(!deserializer.is_valid());
+        CH_CHECK(deserializer.peek_u8() == 0);
+        CH_CHECK(!deserializer.is_valid());
+    }
+
+    void test_truncated_values()
+    {
+        {
+            const std::uint8_t data[] = {0x80, 0x80};
+
+            ch::deserializer deserializer(data, sizeof(data));
+            deserializer.read_varint();
+            CH_CHECK(!deserializer.is_valid());
+        }
+
+        {
+            const std::uint8_t data[] = {1, 2, 3};
+
+            ch::deserializer deserializer(data, sizeof(data));
+            deserializer.read_f32();
+            CH_CHECK(!deserializer.is_valid());
+        }
+
+        {
+            const std::uint8_t data[] = {1};
+
+            ch::deserializer deserializer(data, sizeof(data));
+            deserializer.read_quantized(0, 1);
+            CH_CHECK(!deserializer.is_valid());
+        }
+    }
+
+    void test_overlong_varint()
+    {
+        // more continuation bytes than a 64 bit value can need
+        const std::vector<std::uint8_t> data(11, 0xff);
+
+        ch::deserializer deserializer(data.data(), data.size());
+        CH_CHECK(deserializer.read_varint() == 0);
+        CH_CHECK(!deserializer.is_valid());
+    }
+
+    void test_oversized_frame()
+    {
+        std::vector<std::uint8_t> buffer;
+        ch::serializer serializer(buffer);
+        serializer.write_varint(4);
+        serializer.write_u8(1);
+        serializer.write_u8(2);
+
+        ch::deserializer deserializer(buffer.data(), buffer.size());
+        const auto frame = deserializer.read_frame();
+        CH_CHECK(!deserializer.is_valid());
+        CH_CHECK(frame.get_length() == 0);
+    }
+
+    void test_huge_frame_length()
+    {
+        // a length near the top of the range mustn't wrap the bounds check
+        std::vector<std::uint8_t> buffer;
+        ch::serializer serializer(buffer);
+        serializer.write_varint(UINT64_MAX);
+        serializer.write_u8(1);
+
+        ch::deserializer deserializer(buffer.data(), buffer.size());
+        deserializer.read_frame();
+        CH_CHECK(!deserializer.is_valid());
+    }
+
+    void test_frame_contents_stay_in_frame()
+    {
+        std::vector<std::uint8_t> buffer;
+        ch::serializer serializer(buffer);
+        serializer.write_frame({1});
+        serializer.write_u8(2);
+
+        ch::deserializer deserializer(buffer.data(), buffer.size());
+        auto frame = deserializer.read_frame();
+        CH_CHECK(frame.read_u8() == 1);
+
+        // the byte after the frame belongs to the outer packet
+        CH_CHECK(frame.read_u8() == 0);
+        CH_CHECK(!frame.is_valid());
+        CH_CHECK(deserializer.is_valid());
+        CH_CHECK(deserializer.read_u8() == 2);
+    }
+
+    void test_input_message_counts()
+    {
+        const auto read_input_message = [](const std::uint32_t sequence, const std::uint8_t count)
+        {
+            std::vector<std::uint8_t> buffer;
+            ch::serializer serializer(buffer);
+            serializer.write_u8(static_cast<std::uint8_t>(ch::message_type::input));
+            serializer.write_varint(sequence);
+            serializer.write_u8(count);
+            for (std::uint8_t i = 0; i < count; i++)
+            {
+                serializer.write_u8(0);
+            }
+
+            ch::deserializer deserializer(buffer.data(), buffer.size());
+            ch::message_input message;
+            message.read(deserializer);
+
+            return deserializer.is_valid();
+        };
+
+        CH_CHECK(read_input_message(10, 1));
+        CH_CHECK(read_input_message(10, ch::message_input::max_inputs));
+        CH_CHECK(!read_input_message(10, 0));
+        CH_CHECK(!read_input_message(10, ch::message_input::max_inputs + 1));
+
+        // sequences start at 1, so there can't be more inputs than the newest one's sequence
+        CH_CHECK(!read_input_message(2, 3));
+    }
+}
+
+int main()
+{
+    test_read_past_end();
+    test_truncated_values();
+    test_overlong_varint();
+    test_oversized_frame();
+    test_huge_frame_length();
+    test_frame_contents_stay_in_frame();
+    test_input_message_counts();
+
+    return ch::check_result();
+}
@@ -0,0 +1,75 @@
+#include "check.hpp"
+#include <ch/pool_allocator.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    void test_blocks_are_usable()
+    {
+        for (std::size_t size = 1; size <= 8192; size *= 3)
+        {
+            auto memory = ch::pool_allocator::allocate(size);
+            CH_CHECK(memory);
+            CH_CHECK(reinterpret_cast<std::uintptr_t>(memory) % alignof(std::max_align_t) == 0);
+
+            std::memset(memory, 0xab, size);
+            ch::pool_allocator::deallocate(memory);
+        }
+    }
+
+    void test_freed_blocks_are_reused()
+    {
+        const auto first = ch::pool_allocator::allocate(100);
+        ch::pool_allocator::deallocate(first);
+
+        const auto stats = ch::pool_allocator::get_stats();
+        const auto second = ch::pool_allocator::allocate(100);
+        CH_CHECK(second == first);
+        CH_CHECK(ch::pool_allocator::get_stats().pooled_allocations == stats.pooled_allocations + 1);
+        ch::pool_allocator::deallocate(second);
+    }
+
+    void test_large_blocks_skip_the_pool()
+    {
+        const auto stats = ch::pool_allocator::get_stats();
+        const auto memory = ch::pool_allocator::allocate(1 << 16);
+        CH_CHECK(ch::pool_allocator::get_stats().system_allocations == stats.system_allocations + 1);
+        ch::pool_allocator::deallocate(memory);
+    }
+
+    void test_cross_thread_free()
+    {
+        // the block lands in the freeing thread's cache rather than the one it came from
+        void *memory = nullptr;
+        std::thread allocator(
+            [&memory]()
+            {
+                memory = ch::pool_allocator::allocate(64);
+            });
+        allocator.join();
+
+        CH_CHECK(memory);
+        ch::pool_allocator::deallocate(memory);
+    }
+
+    void test_stats_balance()
+    {
+        const auto stats = ch::pool_allocator::get_stats();
+        CH_CHECK(stats.allocations == stats.frees);
+        CH_CHECK(stats.allocations == stats.pooled_allocations + stats.system_allocations);
+    }
+}
+
+int main()
+{
+    test_blocks_are_usable();
+    test_freed_blocks_are_reused();
+    test_large_blocks_skip_the_pool();
+    test_cross_thread_free();
+    test_stats_balance();
+
+    return ch::check_result();
+}
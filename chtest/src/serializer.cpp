@@ -0,0 +1,158 @@
+#include "check.hpp"
+#include <ch/deserializer.hpp>
+#include <ch/message.hpp>
+#include <ch/serializer.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    void test_scalars()
+    {
+        std::vector<std::uint8_t> buffer;
+        ch::serializer serializer(buffer);
+        serializer.write_u8(0xab);
+        serializer.write_bool(true);
+        serializer.write_bool(false);
+        serializer.write_f32(-1.5f);
+
+        ch::deserializer deserializer(buffer.data(), buffer.size());
+        CH_CHECK(deserializer.read_u8() == 0xab);
+        CH_CHECK(deserializer.read_bool());
+        CH_CHECK(!deserializer.read_bool());
+        CH_CHECK(deserializer.read_f32() == -1.5f);
+        CH_CHECK(deserializer.is_at_end());
+        CH_CHECK(deserializer.is_valid());
+    }
+
+    void test_varints()
+    {
+        const std::uint64_t values[] = {0, 1, 0x7f, 0x80, 300, 0x3fff, 0x4000, std::numeric_limits<std::uint32_t>::max(), std::numeric_limits<std::uint64_t>::max()};
+
+        std::vector<std::uint8_t> buffer;
+        ch::serializer serializer(buffer);
+        for (const auto value : values)
+        {
+            serializer.write_varint(value);
+        }
+
+        // small values are the common case, so they take a single byte
+        CH_CHECK(buffer.at(0) == 0);
+        CH_CHECK(buffer.at(1) == 1);
+
+        ch::deserializer deserializer(buffer.data(), buffer.size());
+        for (const auto value : values)
+        {
+            CH_CHECK(deserializer.read_varint() == value);
+        }
+        CH_CHECK(deserializer.is_at_end());
+        CH_CHECK(deserializer.is_valid());
+    }
+
+    void test_quantized()
+    {
+        constexpr float min = -100.0f;
+        constexpr float max = 100.0f;
+        constexpr float step = (max - min) / UINT16_MAX;
+
+        const float values[] = {min, -37.25f, 0.0f, 12.5f, max};
+
+        std::vector<std::uint8_t> buffer;
+        ch::serializer serializer(buffer);
+        for (const auto value : values)
+        {
+            serializer.write_quantized(value, min, max);
+        }
+        // out of range values are clamped rather than wrapped
+        serializer.write_quantized(max * 2, min, max);
+
+        ch::deserializer deserializer(buffer.data(), buffer.size());
+        for (const auto value : values)
+        {
+            CH_CHECK(std::abs(deserializer.read_quantized(min, max) - value) <= step);
+        }
+        CH_CHECK(deserializer.read_quantized(min, max) == max);
+        CH_CHECK(deserializer.is_valid());
+    }
+
+    void test_frames()
+    {
+        const std::vector<std::uint8_t> first = {1, 2, 3};
+        const std::vector<std::uint8_t> second(200, 7);
+
+        std::vector<std::uint8_t> buffer;
+        ch::serializer serializer(buffer);
+        serializer.write_frame(first);
+        serializer.write_frame({});
+        serializer.write_frame(second);
+
+        ch::deserializer deserializer(buffer.data(), buffer.size());
+
+        auto frame = deserializer.read_frame();
+        CH_CHECK(frame.get_length() == first.size());
+        CH_CHECK(frame.read_u8() == 1);
+        CH_CHECK(frame.read_u8() == 2);
+        CH_CHECK(frame.read_u8() == 3);
+        CH_CHECK(frame.is_at_end());
+
+        frame = deserializer.read_frame();
+        CH_CHECK(frame.get_length() == 0);
+
+        frame = deserializer.read_frame();
+        CH_CHECK(frame.get_length() == second.size());
+
+        CH_CHECK(deserializer.is_at_end());
+        CH_CHECK(deserializer.is_valid());
+    }
+
+    void test_messages()
+    {
+        ch::message_input input_message;
+        input_message.type = ch::message_type::input;
+        input_message.sequence = 42;
+        input_message.inputs = {{-1, 0}, {0, 1}, {1, -1}};
+
+        ch::message_attack attack_message;
+        attack_message.type = ch::message_type::attack;
+        attack_message.view_tick = 123456;
+
+        std::vector<std::uint8_t> buffer;
+        ch::serializer serializer(buffer);
+        input_message.write(serializer);
+        attack_message.write(serializer);
+
+        ch::deserializer deserializer(buffer.data(), buffer.size());
+
+        ch::message_input read_input_message;
+        read_input_message.read(deserializer);
+        CH_CHECK(read_input_message.type == ch::message_type::input);
+        CH_CHECK(read_input_message.sequence == 42);
+        CH_CHECK(read_input_message.inputs.size() == 3);
+        for (std::size_t i = 0; i < read_input_message.inputs.size(); i++)
+        {
+            CH_CHECK(read_input_message.inputs.at(i).input_x == input_message.inputs.at(i).input_x);
+            CH_CHECK(read_input_message.inputs.at(i).input_y == input_message.inputs.at(i).input_y);
+        }
+
+        ch::message_attack read_attack_message;
+        read_attack_message.read(deserializer);
+        CH_CHECK(read_attack_message.type == ch::message_type::attack);
+        CH_CHECK(read_attack_message.view_tick == 123456);
+
+        CH_CHECK(deserializer.is_at_end());
+        CH_CHECK(deserializer.is_valid());
+    }
+}
+
+int main()
+{
+    test_scalars();
+    test_varints();
+    test_quantized();
+    test_frames();
+    test_messages();
+
+    return ch::check_result();
+}
@@ -0,0 +1,69 @@
+#include "check.hpp"
+#include <ch/slot_map.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    void test_insert_and_get()
+    {
+        ch::slot_map<int> map(4);
+        const auto a = map.insert(1);
+        const auto b = map.insert(2);
+
+        CH_CHECK(map.size() == 2);
+        CH_CHECK(map.get(a) && *map.get(a) == 1);
+        CH_CHECK(map.get(b) && *map.get(b) == 2);
+        CH_CHECK(!map.get(ch::slot_handle{}));
+    }
+
+    void test_erase_keeps_other_handles()
+    {
+        ch::slot_map<int> map(4);
+        const auto a = map.insert(1);
+        const auto b = map.insert(2);
+        const auto c = map.insert(3);
+
+        // erasing from the middle moves the last value into the gap
+        map.erase(a);
+        CH_CHECK(map.size() == 2);
+        CH_CHECK(!map.get(a));
+        CH_CHECK(map.get(b) && *map.get(b) == 2);
+        CH_CHECK(map.get(c) && *map.get(c) == 3);
+
+        std::vector<int> values(map.begin(), map.end());
+        std::sort(values.begin(), values.end());
+        CH_CHECK((values == std::vector<int>{2, 3}));
+
+        // erasing twice is harmless
+        map.erase(a);
+        CH_CHECK(map.size() == 2);
+    }
+
+    void test_stale_handles_miss()
+    {
+        ch::slot_map<int> map(1);
+        const auto a = map.insert(1);
+        CH_CHECK(map.full());
+
+        map.erase(a);
+        const auto b = map.insert(2);
+
+        // the slot is reused, but the old handle's generation no longer matches
+        CH_CHECK(b.index == a.index);
+        CH_CHECK(!map.get(a));
+        CH_CHECK(map.get(b) && *map.get(b) == 2);
+
+        map.erase(a);
+        CH_CHECK(map.size() == 1);
+    }
+}
+
+int main()
+{
+    test_insert_and_get();
+    test_erase_keeps_other_handles();
+    test_stale_handles_miss();
+
+    return ch::check_result();
+}
@@ -0,0 +1,88 @@
+#include "check.hpp"
+#include <ch/spsc_queue.hpp>
+#include <cstddef>
+#include <thread>
+
+namespace
+{
+    void test_order_and_capacity()
+    {
+        ch::spsc_queue<int, 4> queue;
+
+        int value = 0;
+        CH_CHECK(!queue.pop(value));
+
+        for (int i = 0; i < 4; i++)
+        {
+            CH_CHECK(queue.push(i));
+        }
+        CH_CHECK(!queue.push(4));
+
+        for (int i = 0; i < 4; i++)
+        {
+            CH_CHECK(queue.pop(value) && value == i);
+        }
+        CH_CHECK(!queue.pop(value));
+    }
+
+    void test_wraparound()
+    {
+        ch::spsc_queue<int, 4> queue;
+
+        int value = 0;
+        for (int i = 0; i < 10; i++)
+        {
+            CH_CHECK(queue.push(i));
+            CH_CHECK(queue.push(i + 100));
+            CH_CHECK(queue.pop(value) && value == i);
+            CH_CHECK(queue.pop(value) && value == i + 100);
+        }
+    }
+
+    void test_threads()
+    {
+        constexpr std::size_t count = 100000;
+
+        ch::spsc_queue<std::size_t, 64> queue;
+
+        std::thread producer(
+            [&queue]()
+            {
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    while (!queue.push(i))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+
+        // everything arrives once and in order
+        auto in_order = true;
+        for (std::size_t expected = 0; expected < count;)
+        {
+            std::size_t value = 0;
+            if (queue.pop(value))
+            {
+                in_order = in_order && value == expected;
+                expected++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        CH_CHECK(in_order);
+
+        producer.join();
+    }
+}
+
+int main()
+{
+    test_order_and_capacity();
+    test_wraparound();
+    test_threads();
+
+    return ch::check_result();
+}